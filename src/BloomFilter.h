@@ -0,0 +1,140 @@
+#ifndef AISDI_MAPS_BLOOMFILTER_H
+#define AISDI_MAPS_BLOOMFILTER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+namespace detail
+{
+
+// Blocked Bloom filter over hash values. Every key sets one bit in each of
+// the 8 words of a single 64-byte block, so a query reads one cache line and
+// a miss is usually told apart from a hit without touching anything else.
+// Sized for an expected number of keys at bitsPerKey bits each, which keeps
+// false positives around 1% up to that many keys.
+// Keys cannot be taken out: the owner rebuilds the filter from its contents
+// once enough of them are gone.
+class BlockedBloomFilter
+{
+public:
+  BlockedBloomFilter() : blocks(0), offset(0)
+  {
+  }
+
+  explicit BlockedBloomFilter(std::size_t expectedKeys)
+      : blocks(std::max<std::size_t>((expectedKeys * bitsPerKey + blockBits - 1) / blockBits, 1)),
+        words(blocks * blockWords + blockWords - 1, 0), offset(alignedOffset(words))
+  {
+  }
+
+  BlockedBloomFilter(const BlockedBloomFilter &other)
+      : blocks(other.blocks), words(other.words.size(), 0), offset(alignedOffset(words))
+  {
+    std::copy(other.block(0), other.block(blocks), block(0));
+  }
+
+  BlockedBloomFilter(BlockedBloomFilter &&other) noexcept : BlockedBloomFilter()
+  {
+    swap(other);
+  }
+
+  BlockedBloomFilter &operator=(BlockedBloomFilter other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  void add(std::size_t hash)
+  {
+    if (blocks == 0)
+      return;
+
+    const auto h = mixHash(hash);
+    auto target = block(blockIndex(h));
+    for (unsigned i = 0; i < blockWords; ++i)
+      target[i] |= bitMask(h, i);
+  }
+
+  // False means the key was never added; true may be a false positive.
+  // An unsized filter answers true for every key.
+  bool mayContain(std::size_t hash) const
+  {
+    if (blocks == 0)
+      return true;
+
+    const auto h = mixHash(hash);
+    auto source = block(blockIndex(h));
+    for (unsigned i = 0; i < blockWords; ++i)
+    {
+      if ((source[i] & bitMask(h, i)) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  bool isSized() const
+  {
+    return blocks != 0;
+  }
+
+  void swap(BlockedBloomFilter &other) noexcept
+  {
+    std::swap(blocks, other.blocks);
+    words.swap(other.words);
+    std::swap(offset, other.offset);
+  }
+
+private:
+  static const unsigned blockWords = 8;
+  static const std::size_t blockBits = blockWords * 64;
+  static const std::size_t bitsPerKey = 12;
+
+  std::size_t blocks;
+  // over-allocated by a block less a word, blocks start at offset on a
+  // 64-byte boundary (std::vector does not honour alignas before C++17)
+  std::vector<std::uint64_t> words;
+  std::size_t offset;
+
+  static std::size_t alignedOffset(const std::vector<std::uint64_t> &words)
+  {
+    const auto address = reinterpret_cast<std::uintptr_t>(words.data());
+    return (blockWords - address / sizeof(std::uint64_t) % blockWords) % blockWords;
+  }
+
+  std::uint64_t *block(std::size_t index)
+  {
+    return words.data() + offset + index * blockWords;
+  }
+
+  const std::uint64_t *block(std::size_t index) const
+  {
+    return words.data() + offset + index * blockWords;
+  }
+
+  // High half of the mixed hash picks the block (multiply-shift, no modulo),
+  // the low half the bits in it.
+  std::size_t blockIndex(std::uint64_t h) const
+  {
+    return static_cast<std::size_t>(((h >> 32) * static_cast<std::uint64_t>(blocks)) >> 32);
+  }
+
+  // Same odd multipliers as the split block filters of Parquet and Impala.
+  static std::uint64_t bitMask(std::uint64_t h, unsigned word)
+  {
+    static const std::uint32_t salts[blockWords] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                     0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+    const auto bit = (static_cast<std::uint32_t>(h) * salts[word]) >> 26;
+    return std::uint64_t(1) << bit;
+  }
+};
+
+} // namespace detail
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_BLOOMFILTER_H */
@@ -0,0 +1,242 @@
+#ifndef AISDI_MAPS_CONCURRENTHASHMAP_H
+#define AISDI_MAPS_CONCURRENTHASHMAP_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "HashMap.h"
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Thread-safe map made of independent HashMap shards. A key always lives in
+// the shard picked by its hash, and every shard has its own reader-writer
+// lock, so operations on different shards never wait for each other; that
+// includes a shard growing its table. Values are handed out by copy or to a
+// callback run under the lock, never by reference.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class ConcurrentHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using shard_type = HashMap<KeyType, ValueType, Hash, KeyEqual>;
+
+  // Shard count is rounded up to a power of two; the default gives every
+  // hardware thread a few shards to spread contention.
+  explicit ConcurrentHashMap(size_type shardCount = defaultShardCount(),
+                             const Hash &hashFunction = Hash(), const KeyEqual &keyEqual = KeyEqual())
+      : shardCount(detail::roundUpToPowerOfTwo(shardCount == 0 ? 1 : shardCount)),
+        shards(new Shard[this->shardCount]), hashFunction(hashFunction)
+  {
+    for (size_type i = 0; i < this->shardCount; ++i)
+      shards[i].map = shard_type(hashFunction, keyEqual);
+  }
+
+  ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+  ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+  // Inserts the value or, if the key is present, assigns it. Returns true if inserted.
+  template <typename M>
+  bool upsert(const key_type &key, M &&value)
+  {
+    auto &shard = shardOf(key);
+    WriteLock lock(shard.mutex);
+    return shard.map.insert_or_assign(key, std::forward<M>(value)).second;
+  }
+
+  // Inserts the value, or calls update(mapped_type &) on the present one.
+  // Returns true if inserted.
+  template <typename M, typename Update>
+  bool upsert(const key_type &key, M &&value, Update update)
+  {
+    auto &shard = shardOf(key);
+    WriteLock lock(shard.mutex);
+    auto result = shard.map.try_emplace(key, std::forward<M>(value));
+    if (!result.second)
+      update(result.first->second);
+    return result.second;
+  }
+
+  // Returns the value of key, first inserting factory() if the key is missing.
+  // Among threads racing on the same missing key only one calls the factory.
+  template <typename Factory>
+  mapped_type compute_if_absent(const key_type &key, Factory factory)
+  {
+    auto &shard = shardOf(key);
+    {
+      ReadLock lock(shard.mutex);
+      auto it = shard.map.find(key);
+      if (it != shard.map.end())
+        return it->second;
+    }
+
+    WriteLock lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end())
+      return it->second;
+    return shard.map.try_emplace(key, factory()).first->second;
+  }
+
+  // Removes key if predicate(const mapped_type &) holds for its value.
+  // Returns true if removed.
+  template <typename Predicate>
+  bool erase_if(const key_type &key, Predicate predicate)
+  {
+    auto &shard = shardOf(key);
+    WriteLock lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end() || !predicate(static_cast<const mapped_type &>(it->second)))
+      return false;
+
+    shard.map.remove(it);
+    return true;
+  }
+
+  // Returns true if removed.
+  bool remove(const key_type &key)
+  {
+    return erase_if(key, [](const mapped_type &) { return true; });
+  }
+
+  mapped_type valueOf(const key_type &key) const
+  {
+    auto &shard = shardOf(key);
+    ReadLock lock(shard.mutex);
+    return shard.map.valueOf(key);
+  }
+
+  bool contains(const key_type &key) const
+  {
+    auto &shard = shardOf(key);
+    ReadLock lock(shard.mutex);
+    return shard.map.find(key) != shard.map.end();
+  }
+
+  // Calls visitor(const mapped_type &) under the shard's read lock.
+  // Returns false if the key is missing.
+  template <typename Visitor>
+  bool visit(const key_type &key, Visitor visitor) const
+  {
+    auto &shard = shardOf(key);
+    ReadLock lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end())
+      return false;
+
+    visitor(it->second);
+    return true;
+  }
+
+  // Calls visitor(const value_type &) for every item, one shard at a time.
+  // Items added or removed meanwhile in other shards may or may not be seen.
+  template <typename Visitor>
+  void forEach(Visitor visitor) const
+  {
+    for (size_type i = 0; i < shardCount; ++i)
+    {
+      ReadLock lock(shards[i].mutex);
+      for (auto &item : shards[i].map)
+        visitor(item);
+    }
+  }
+
+  // Sum of the shard sizes, each read under its own lock, so with concurrent
+  // writers it is a size the map had at no particular moment.
+  size_type getSize() const
+  {
+    size_type result = 0;
+    for (size_type i = 0; i < shardCount; ++i)
+    {
+      ReadLock lock(shards[i].mutex);
+      result += shards[i].map.getSize();
+    }
+    return result;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // Spreads the reservation evenly over the shards.
+  void reserve(size_type count)
+  {
+    for (size_type i = 0; i < shardCount; ++i)
+    {
+      WriteLock lock(shards[i].mutex);
+      shards[i].map.reserve(count / shardCount + 1);
+    }
+  }
+
+  // Incremental mode keeps each write lock short when a shard grows.
+  void setRehashMode(RehashMode mode)
+  {
+    for (size_type i = 0; i < shardCount; ++i)
+    {
+      WriteLock lock(shards[i].mutex);
+      shards[i].map.setRehashMode(mode);
+    }
+  }
+
+  size_type getShardCount() const
+  {
+    return shardCount;
+  }
+
+private:
+  using Mutex = std::shared_timed_mutex;
+  using ReadLock = std::shared_lock<Mutex>;
+  using WriteLock = std::unique_lock<Mutex>;
+
+  static const size_type cacheLineSize = 64;
+
+  // The trailing padding keeps the lock and table header of neighbouring
+  // shards on different cache lines, whatever the alignment of the array.
+  struct Shard
+  {
+    mutable Mutex mutex;
+    shard_type map;
+    char padding[cacheLineSize];
+  };
+
+  size_type shardCount;
+  std::unique_ptr<Shard[]> shards;
+  Hash hashFunction;
+
+  static size_type defaultShardCount()
+  {
+    auto threads = std::thread::hardware_concurrency();
+    return 4 * (threads == 0 ? 8 : threads);
+  }
+
+  // Shards take the top bits of the mixed hash; the shard's own table indexes
+  // with the low ones, so the two choices stay independent.
+  const Shard &shardOf(const key_type &key) const
+  {
+    auto h = detail::mixHash(hashFunction(key));
+    return shards[(h >> 32) & (shardCount - 1)];
+  }
+
+  Shard &shardOf(const key_type &key)
+  {
+    return const_cast<Shard &>(static_cast<const ConcurrentHashMap &>(*this).shardOf(key));
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_CONCURRENTHASHMAP_H */
@@ -0,0 +1,223 @@
+#ifndef AISDI_MAPS_CONSTEXPRMAP_H
+#define AISDI_MAPS_CONSTEXPRMAP_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+namespace aisdi
+{
+
+template <typename Key, typename Value>
+struct ConstexprEntry
+{
+  Key first;
+  Value second;
+};
+
+// Orders C strings by their characters, for ConstexprMap<const char *, ...>;
+// std::less would compare the pointers.
+struct CStringLess
+{
+  constexpr bool operator()(const char *lhs, const char *rhs) const
+  {
+    while (*lhs != '\0' && *lhs == *rhs)
+    {
+      ++lhs;
+      ++rhs;
+    }
+    return static_cast<unsigned char>(*lhs) < static_cast<unsigned char>(*rhs);
+  }
+};
+
+// Read-only map over N items known at compile time, for keyword and opcode
+// tables. The constructor sorts the items during constant evaluation, so a
+// constexpr ConstexprMap lives in read-only data and costs nothing at startup.
+// Lookups are a binary search without branches on the keys, of a fixed number
+// of steps the compiler unrolls; a lookup of a constant key folds away.
+//
+// Keys and values have to be literal types with constexpr default
+// constructors. Keys are compared with Compare, equal keys are an error: a
+// compile-time one in constant evaluation, std::invalid_argument otherwise.
+template <typename KeyType, typename ValueType, std::size_t N, typename Compare = std::less<KeyType>>
+class ConstexprMap
+{
+  static_assert(N > 0, "ConstexprMap needs at least one item");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = ConstexprEntry<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using key_compare = Compare;
+
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+  using iterator = ConstIterator;
+
+  constexpr explicit ConstexprMap(const value_type (&list)[N], const Compare &compare = Compare())
+      : items{}, compare(compare)
+  {
+    for (size_type i = 0; i < N; ++i)
+      items[i] = list[i];
+    sort();
+  }
+
+  constexpr bool isEmpty() const
+  {
+    return false;
+  }
+
+  constexpr size_type getSize() const
+  {
+    return N;
+  }
+
+  constexpr bool contains(const key_type &key) const
+  {
+    return indexOf(key) != N;
+  }
+
+  constexpr const_iterator find(const key_type &key) const
+  {
+    return const_iterator(items + indexOf(key), items + N);
+  }
+
+  constexpr const mapped_type &valueOf(const key_type &key) const
+  {
+    auto index = indexOf(key);
+    if (index == N)
+      throw std::out_of_range("Key does not exists");
+    return items[index].second;
+  }
+
+  constexpr const_iterator begin() const
+  {
+    return const_iterator(items, items + N);
+  }
+
+  constexpr const_iterator end() const
+  {
+    return const_iterator(items + N, items + N);
+  }
+
+  constexpr const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  constexpr const_iterator cend() const
+  {
+    return end();
+  }
+
+private:
+  value_type items[N];
+  Compare compare;
+
+  // Insertion sort: N is small and the work is done by the compiler.
+  constexpr void sort()
+  {
+    for (size_type i = 1; i < N; ++i)
+    {
+      auto item = items[i];
+      auto j = i;
+      for (; j > 0 && compare(item.first, items[j - 1].first); --j)
+        items[j] = items[j - 1];
+      items[j] = item;
+    }
+    for (size_type i = 1; i < N; ++i)
+    {
+      if (!compare(items[i - 1].first, items[i].first))
+        throw std::invalid_argument("Duplicate key in ConstexprMap");
+    }
+  }
+
+  // Lower bound that halves the range by moving its start, never by
+  // branching on the comparison, so the loop compiles to conditional moves.
+  constexpr size_type indexOf(const key_type &key) const
+  {
+    size_type first = 0;
+    for (size_type length = N; length > 1; length -= length / 2)
+      first = compare(items[first + length / 2].first, key) ? first + length / 2 : first;
+    first += compare(items[first].first, key);
+    return first != N && !compare(key, items[first].first) ? first : N;
+  }
+};
+
+// Deduces N from a braced list, e.g.
+//   constexpr auto opcodes = makeConstexprMap<int, const char *>({ { 0x90, "nop" }, { 0xc3, "ret" } });
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>, std::size_t N>
+constexpr ConstexprMap<KeyType, ValueType, N, Compare> makeConstexprMap(
+    const ConstexprEntry<KeyType, ValueType> (&list)[N], const Compare &compare = Compare())
+{
+  return ConstexprMap<KeyType, ValueType, N, Compare>(list, compare);
+}
+
+// Forward iterator over the items, in key order.
+template <typename KeyType, typename ValueType, std::size_t N, typename Compare>
+class ConstexprMap<KeyType, ValueType, N, Compare>::ConstIterator
+{
+public:
+  using reference = typename ConstexprMap::const_reference;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename ConstexprMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+
+  constexpr ConstIterator() : item(nullptr), last(nullptr)
+  {
+  }
+
+  constexpr ConstIterator(const value_type *item, const value_type *last) : item(item), last(last)
+  {
+  }
+
+  constexpr ConstIterator &operator++()
+  {
+    if (item == last)
+      throw std::out_of_range("Incrementing end iterator");
+    ++item;
+    return *this;
+  }
+
+  constexpr ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  constexpr reference operator*() const
+  {
+    if (item == last)
+      throw std::out_of_range("Dereferencing end iterator");
+    return *item;
+  }
+
+  constexpr pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  constexpr bool operator==(const ConstIterator &other) const
+  {
+    return item == other.item;
+  }
+
+  constexpr bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  const value_type *item;
+  const value_type *last;
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_CONSTEXPRMAP_H */
@@ -0,0 +1,555 @@
+#ifndef AISDI_MAPS_DENSEHASHMAP_H
+#define AISDI_MAPS_DENSEHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Items live in one contiguous array, in insertion order; a separate linear
+// probing index maps keys to their 32-bit positions in it. Iteration is a
+// plain array scan and never looks at the index. Removal moves the last item
+// into the hole, so the array stays gapless but loses insertion order from
+// that point on, and the iterators to the moved item are invalidated.
+//
+// Every index slot keeps the low half of the key's hash next to the position.
+// Lookups skip non-matching slots without touching the items, and the index
+// is rebuilt on growth without hashing any key again.
+template <typename KeyType, typename ValueType>
+class DenseHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  DenseHashMap() = default;
+
+  DenseHashMap(std::initializer_list<value_type> list)
+  {
+    reserveFor(list.size());
+    for (auto &item : list)
+      tryEmplace(item.first, item.second);
+  }
+
+  DenseHashMap(const DenseHashMap &other) : index(other.index), mask(other.mask)
+  {
+    if (other.size == 0)
+      return;
+
+    allocateItems(other.size);
+    try
+    {
+      for (; size < other.size; ++size)
+        new (items + size) value_type(other.items[size]);
+    }
+    catch (...)
+    {
+      // size counts the items made so far
+      release();
+      throw;
+    }
+  }
+
+  DenseHashMap(DenseHashMap &&other) noexcept
+  {
+    swap(other);
+  }
+
+  DenseHashMap &operator=(const DenseHashMap &other)
+  {
+    if (this != &other)
+    {
+      DenseHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  DenseHashMap &operator=(DenseHashMap &&other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~DenseHashMap()
+  {
+    release();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type &operator[](const key_type &key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  mapped_type &operator[](key_type &&key)
+  {
+    return tryEmplace(std::move(key)).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+  {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+  {
+    return insertOrAssign(key, std::forward<M>(value));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+  {
+    return insertOrAssign(std::move(key), std::forward<M>(value));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return tryEmplace(std::move(value.first), std::move(value.second));
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    const_iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  mapped_type &valueOf(const key_type &key)
+  {
+    iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    auto slot = findSlot(key, hashOf(key));
+    return const_iterator(this, slot == noSlot ? size : index[slot].position);
+  }
+
+  iterator find(const key_type &key)
+  {
+    return iterator(static_cast<const DenseHashMap &>(*this).find(key));
+  }
+
+  void remove(const key_type &key)
+  {
+    auto slot = findSlot(key, hashOf(key));
+    if (slot == noSlot)
+      throw std::out_of_range("Removing non existing key");
+
+    eraseSlot(slot);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    eraseSlot(findSlot(it->first, hashOf(it->first)));
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const DenseHashMap &other) const
+  {
+    if (size != other.size)
+      return false;
+
+    for (auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const DenseHashMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator cend() const
+  {
+    return const_iterator(this, size);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  struct Slot
+  {
+    std::uint32_t position;
+    std::uint32_t hash;
+  };
+
+  static const std::uint32_t emptyPosition = std::numeric_limits<std::uint32_t>::max();
+  static const size_type noSlot = std::numeric_limits<size_type>::max();
+  static const size_type minimumIndexSize = 16;
+
+  value_type *items = nullptr;
+  size_type size = 0;
+  size_type itemsCapacity = 0;
+  std::vector<Slot> index;
+  size_type mask = 0;
+
+  // linear probing degrades quickly past three quarters full
+  static size_type maxLoad(size_type indexSize)
+  {
+    return indexSize / 2 + indexSize / 4;
+  }
+
+  static std::uint32_t hashOf(const key_type &key)
+  {
+    return static_cast<std::uint32_t>(detail::mixHash(std::hash<key_type>{}(key)));
+  }
+
+  size_type findSlot(const key_type &key, std::uint32_t hash) const
+  {
+    if (index.empty())
+      return noSlot;
+
+    for (size_type slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+      const auto &entry = index[slot];
+      if (entry.position == emptyPosition)
+        return noSlot;
+      if (entry.hash == hash && items[entry.position].first == key)
+        return slot;
+    }
+  }
+
+  void placeInIndex(Slot entry)
+  {
+    auto slot = entry.hash & mask;
+    while (index[slot].position != emptyPosition)
+      slot = (slot + 1) & mask;
+    index[slot] = entry;
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+  {
+    const auto h = hashOf(key);
+    auto slot = findSlot(key, h);
+    if (slot != noSlot)
+      return { iterator(const_iterator(this, index[slot].position)), false };
+
+    if (size + 1 >= emptyPosition)
+      throw std::length_error("DenseHashMap holds at most 2^32 - 1 items");
+    // built before growing, as the arguments may refer to items of this map
+    value_type value(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    if (size + 1 > maxLoad(index.size()))
+      rebuildIndex(index.empty() ? size_type(minimumIndexSize) : index.size() * 2);
+    if (size == itemsCapacity)
+      allocateItems(itemsCapacity == 0 ? size_type(minimumIndexSize) : itemsCapacity * 2);
+
+    new (items + size) value_type(std::move(value));
+    placeInIndex({ static_cast<std::uint32_t>(size), h });
+    return { iterator(const_iterator(this, size++)), true };
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K &&key, M &&value)
+  {
+    auto result = tryEmplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  // Empties the slot and closes the gap by shifting back the rest of the
+  // cluster, then moves the last item into the freed position.
+  void eraseSlot(size_type slot)
+  {
+    const auto position = index[slot].position;
+
+    auto hole = slot;
+    for (auto next = (hole + 1) & mask; index[next].position != emptyPosition; next = (next + 1) & mask)
+    {
+      // an entry may move back only if that does not put it before its home
+      const auto home = index[next].hash & mask;
+      if (((next - home) & mask) >= ((next - hole) & mask))
+      {
+        index[hole] = index[next];
+        hole = next;
+      }
+    }
+    index[hole].position = emptyPosition;
+
+    const auto last = size - 1;
+    if (position != last)
+    {
+      const auto h = hashOf(items[last].first);
+      auto moved = h & mask;
+      while (index[moved].position != last)
+        moved = (moved + 1) & mask;
+      index[moved].position = position;
+      items[position] = std::move(items[last]);
+    }
+    items[last].~value_type();
+    --size;
+  }
+
+  void reserveFor(size_type count)
+  {
+    size_type indexSize = minimumIndexSize;
+    while (maxLoad(indexSize) < count)
+      indexSize *= 2;
+    if (indexSize > index.size())
+      rebuildIndex(indexSize);
+    if (count > itemsCapacity)
+      allocateItems(count);
+  }
+
+  void rebuildIndex(size_type indexSize)
+  {
+    std::vector<Slot> old(indexSize, Slot{ emptyPosition, 0 });
+    old.swap(index);
+    mask = indexSize - 1;
+    for (auto &entry : old)
+    {
+      if (entry.position != emptyPosition)
+        placeInIndex(entry);
+    }
+  }
+
+  // Items are always moved to the new array, even if their move constructor
+  // may throw; std::vector would copy them instead.
+  void allocateItems(size_type capacity)
+  {
+    auto fresh = std::allocator<value_type>{}.allocate(capacity);
+    for (size_type i = 0; i < size; ++i)
+    {
+      new (fresh + i) value_type(std::move(items[i]));
+      items[i].~value_type();
+    }
+    if (items != nullptr)
+      std::allocator<value_type>{}.deallocate(items, itemsCapacity);
+    items = fresh;
+    itemsCapacity = capacity;
+  }
+
+  void release()
+  {
+    if (items != nullptr)
+    {
+      for (size_type i = 0; i < size; ++i)
+        items[i].~value_type();
+      std::allocator<value_type>{}.deallocate(items, itemsCapacity);
+      items = nullptr;
+    }
+    index.clear();
+    size = itemsCapacity = mask = 0;
+  }
+
+  void swap(DenseHashMap &other) noexcept
+  {
+    std::swap(items, other.items);
+    std::swap(size, other.size);
+    std::swap(itemsCapacity, other.itemsCapacity);
+    std::swap(index, other.index);
+    std::swap(mask, other.mask);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class DenseHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename DenseHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename DenseHashMap::value_type;
+  using pointer = const typename DenseHashMap::value_type *;
+  using size_type = typename DenseHashMap::size_type;
+
+  explicit ConstIterator(const DenseHashMap *map, size_type position) : map(map), position(position)
+  {
+  }
+
+  ConstIterator(const ConstIterator &other) : map(other.map), position(other.position)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (position >= map->size)
+      throw std::out_of_range("Incrementing end iterator");
+
+    ++position;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    operator++();
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    if (position == 0)
+      throw std::out_of_range("Decrementing begin iterator");
+
+    --position;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (position >= map->size)
+      throw std::out_of_range("Dereferencing end iterator");
+    return map->items[position];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return position == other.position;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+  const DenseHashMap *map;
+  size_type position;
+};
+
+template <typename KeyType, typename ValueType>
+class DenseHashMap<KeyType, ValueType>::Iterator : public DenseHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename DenseHashMap::reference;
+  using pointer = typename DenseHashMap::value_type *;
+
+  Iterator(const ConstIterator &other)
+      : ConstIterator(other)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_DENSEHASHMAP_H */
@@ -0,0 +1,197 @@
+#ifndef AISDI_MAPS_EPOCHRECLAIMER_H
+#define AISDI_MAPS_EPOCHRECLAIMER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aisdi
+{
+namespace detail
+{
+
+// Epoch-based reclamation for lock-free structures. Readers and writers wrap
+// every access in a Guard; a node unlinked from a structure is handed to
+// retire() and freed only once no thread can still be looking at it.
+//
+// A thread inside a guard is pinned to the global epoch it saw on entry, and
+// the global epoch only advances when every pinned thread has caught up with
+// it. Whatever a thread retired in its epoch e is unreachable for threads
+// entering later, and everybody who entered earlier is gone by epoch e + 3.
+//
+// One process-wide instance serves every structure. A thread keeps its
+// record, and the garbage retired through it, until it exits; the next thread
+// to start takes the record over together with that garbage.
+class EpochReclaimer
+{
+  struct ThreadRecord;
+
+public:
+  using Deleter = void (*)(void *);
+
+  class Guard
+  {
+  public:
+    Guard() : record(&EpochReclaimer::instance().threadRecord())
+    {
+      EpochReclaimer::instance().enter(*record);
+    }
+
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+    ~Guard()
+    {
+      EpochReclaimer::instance().exit(*record);
+    }
+
+  private:
+    ThreadRecord *record;
+  };
+
+  static EpochReclaimer &instance()
+  {
+    // never destroyed, threads may still retire while statics are torn down
+    static auto reclaimer = new EpochReclaimer();
+    return *reclaimer;
+  }
+
+  // Has to be called inside a Guard, on a node that is already unreachable.
+  void retire(void *pointer, Deleter deleter)
+  {
+    auto &record = threadRecord();
+    record.retired.push_back({ pointer, deleter, record.epoch.load() });
+    if (record.retired.size() % advanceInterval == 0)
+      tryAdvance();
+  }
+
+  // Tries to move the epoch far enough for everything this thread retired to
+  // be freed, then frees what it can. Never waits for other threads; best
+  // called outside any Guard, which would hold the epoch back.
+  void flush()
+  {
+    for (int i = 0; i < 3; ++i)
+      tryAdvance();
+    reclaim(threadRecord(), globalEpoch.load());
+  }
+
+  std::uint64_t currentEpoch() const
+  {
+    return globalEpoch.load();
+  }
+
+private:
+  struct Retired
+  {
+    void *pointer;
+    Deleter deleter;
+    std::uint64_t epoch;
+  };
+
+  struct ThreadRecord
+  {
+    std::atomic<std::uint64_t> epoch{ 0 };
+    std::atomic<bool> active{ false };
+    std::atomic<bool> inUse{ false };
+    ThreadRecord *next = nullptr;
+    // owned by the thread holding the record
+    unsigned nesting = 0;
+    std::vector<Retired> retired;
+    // keeps the epoch and flag of neighbouring records off one cache line,
+    // so entering a guard never writes to a line another thread reads often
+    char padding[64];
+  };
+
+  // Releases the thread's record when the thread exits.
+  struct RecordOwner
+  {
+    ThreadRecord *record = nullptr;
+
+    ~RecordOwner()
+    {
+      if (record != nullptr)
+        record->inUse.store(false);
+    }
+  };
+
+  static const std::size_t advanceInterval = 64;
+
+  std::atomic<std::uint64_t> globalEpoch{ 0 };
+  std::atomic<ThreadRecord *> records{ nullptr };
+
+  EpochReclaimer() = default;
+
+  ThreadRecord &threadRecord()
+  {
+    static thread_local RecordOwner owner;
+    if (owner.record == nullptr)
+      owner.record = acquireRecord();
+    return *owner.record;
+  }
+
+  ThreadRecord *acquireRecord()
+  {
+    for (auto record = records.load(); record != nullptr; record = record->next)
+    {
+      bool expected = false;
+      if (record->inUse.compare_exchange_strong(expected, true))
+        return record;
+    }
+
+    auto record = new ThreadRecord();
+    record->inUse.store(true);
+    auto head = records.load();
+    do
+      record->next = head;
+    while (!records.compare_exchange_weak(head, record));
+    return record;
+  }
+
+  void enter(ThreadRecord &record)
+  {
+    if (record.nesting++ > 0)
+      return;
+
+    record.active.store(true);
+    const auto epoch = globalEpoch.load();
+    if (record.epoch.load() != epoch)
+    {
+      record.epoch.store(epoch);
+      reclaim(record, epoch);
+    }
+  }
+
+  void exit(ThreadRecord &record)
+  {
+    if (--record.nesting == 0)
+      record.active.store(false);
+  }
+
+  // Frees what the record retired three or more epochs ago.
+  static void reclaim(ThreadRecord &record, std::uint64_t epoch)
+  {
+    auto safe = std::partition(record.retired.begin(), record.retired.end(),
+                               [epoch](const Retired &item) { return item.epoch + 3 > epoch; });
+    for (auto it = safe; it != record.retired.end(); ++it)
+      it->deleter(it->pointer);
+    record.retired.erase(safe, record.retired.end());
+  }
+
+  void tryAdvance()
+  {
+    auto epoch = globalEpoch.load();
+    for (auto record = records.load(); record != nullptr; record = record->next)
+    {
+      if (record->active.load() && record->epoch.load() != epoch)
+        return;
+    }
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+  }
+};
+
+} // namespace detail
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_EPOCHRECLAIMER_H */
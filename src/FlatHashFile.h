@@ -0,0 +1,331 @@
+#ifndef AISDI_MAPS_FLATHASHFILE_H
+#define AISDI_MAPS_FLATHASHFILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+namespace detail
+{
+
+// On-disk image of a hash table with fixed-width keys and values, written by
+// saveFlat() and read in place by MappedHashMap (POSIX only).
+//
+// The file is a FlatHeader followed, at flatDataOffset, by slotCount slots of
+// open addressing with linear probing. A slot holds the mixed hash of its key
+// with the lowest bit set (0 marks an empty slot) and the key and value bytes
+// as laid out in memory, so the file can only be read back on a machine with
+// the same byte order and type layout; the header records enough to check.
+// The table is at most half full, so a miss ends at an empty slot quickly.
+
+template <typename Key, typename Value>
+struct FlatEntry
+{
+  Key first;
+  Value second;
+};
+
+template <typename Key, typename Value>
+struct FlatSlot
+{
+  std::uint64_t tag;
+  FlatEntry<Key, Value> entry;
+};
+
+struct FlatHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint32_t keySize;
+  std::uint32_t valueSize;
+  std::uint32_t slotSize;
+  std::uint32_t slotAlignment;
+  std::uint64_t hashFingerprint;
+  std::uint64_t slotCount;
+  std::uint64_t size;
+};
+
+constexpr char flatMagic[8] = { 'A', 'I', 'S', 'D', 'I', 'M', 'A', 'P' };
+constexpr std::uint32_t flatVersion = 1;
+constexpr std::uint32_t flatByteOrder = 0x01020304;
+constexpr std::size_t flatDataOffset = 64;
+
+static_assert(sizeof(FlatHeader) <= flatDataOffset, "Flat header does not fit before the slots");
+
+template <typename Key, typename Value>
+void checkFlatTypes()
+{
+  static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                "Only trivially copyable keys and values can be stored in a flat file");
+  static_assert(alignof(FlatSlot<Key, Value>) <= flatDataOffset, "Flat slots are aligned too strictly");
+}
+
+// Identifies the hash function, so that a file is never searched with
+// another one: its type plus what it makes of a value-initialized key.
+// Neither is a proof, but both catch the usual mistakes.
+template <typename Hash, typename Key>
+std::uint64_t flatHashFingerprint(const Hash &hash)
+{
+  const char *name = typeid(Hash).name();
+  return hashBytes(name, std::strlen(name)) ^ mixHash(hash(Key()));
+}
+
+inline std::uint64_t flatTag(std::size_t hash)
+{
+  return mixHash(hash) | 1;
+}
+
+inline std::uint64_t flatSlotCount(std::uint64_t size)
+{
+  return roundUpToPowerOfTwo(static_cast<std::size_t>(size * 2 + 1));
+}
+
+inline std::system_error fileError(const std::string &what, const std::string &path)
+{
+  int error = errno;
+  return std::system_error(error, std::generic_category(), what + " " + path);
+}
+
+// Owns a file descriptor and a mapping of the whole file.
+class FileMapping
+{
+public:
+  FileMapping() : descriptor(-1), data(nullptr), length(0)
+  {
+  }
+
+  FileMapping(const FileMapping &) = delete;
+  FileMapping &operator=(const FileMapping &) = delete;
+
+  FileMapping(FileMapping &&other) : FileMapping()
+  {
+    swap(other);
+  }
+
+  FileMapping &operator=(FileMapping &&other)
+  {
+    FileMapping(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~FileMapping()
+  {
+    if (data != nullptr)
+      ::munmap(data, length);
+    if (descriptor >= 0)
+      ::close(descriptor);
+  }
+
+  // Maps an existing file for reading. The pages are shared with every
+  // other process that maps the same file and come from the page cache.
+  static FileMapping openForReading(const std::string &path)
+  {
+    FileMapping mapping;
+    mapping.descriptor = ::open(path.c_str(), O_RDONLY);
+    if (mapping.descriptor < 0)
+      throw fileError("Cannot open", path);
+
+    struct stat status;
+    if (::fstat(mapping.descriptor, &status) != 0)
+      throw fileError("Cannot stat", path);
+    mapping.map(static_cast<std::size_t>(status.st_size), PROT_READ, path);
+    return mapping;
+  }
+
+  // Creates a new file of length zero bytes and maps it for writing. The
+  // trailing XXXXXX of path is replaced by mkstemp() with a unique suffix,
+  // path holds the name of the file once it exists. Pages that are never
+  // written take no space on disk.
+  static FileMapping createTemporary(std::string &path, std::size_t length)
+  {
+    FileMapping mapping;
+    std::string name = path;
+    mapping.descriptor = ::mkstemp(&name[0]);
+    if (mapping.descriptor < 0)
+      throw fileError("Cannot create", path);
+    path = name;
+    if (::fchmod(mapping.descriptor, 0644) != 0)
+      throw fileError("Cannot set mode of", path);
+    if (::ftruncate(mapping.descriptor, static_cast<off_t>(length)) != 0)
+      throw fileError("Cannot resize", path);
+    mapping.map(length, PROT_READ | PROT_WRITE, path);
+    return mapping;
+  }
+
+  // Writes the mapped pages back and waits for the disk.
+  void flush(const std::string &path)
+  {
+    if (data != nullptr && ::msync(data, length, MS_SYNC) != 0)
+      throw fileError("Cannot write", path);
+    if (::fsync(descriptor) != 0)
+      throw fileError("Cannot write", path);
+  }
+
+  char *bytes() const
+  {
+    return static_cast<char *>(data);
+  }
+
+  std::size_t getLength() const
+  {
+    return length;
+  }
+
+  void swap(FileMapping &other)
+  {
+    std::swap(descriptor, other.descriptor);
+    std::swap(data, other.data);
+    std::swap(length, other.length);
+  }
+
+private:
+  int descriptor;
+  void *data;
+  std::size_t length;
+
+  void map(std::size_t fileLength, int protection, const std::string &path)
+  {
+    if (fileLength == 0)
+      return;
+
+    data = ::mmap(nullptr, fileLength, protection, MAP_SHARED, descriptor, 0);
+    if (data == MAP_FAILED)
+    {
+      data = nullptr;
+      throw fileError("Cannot map", path);
+    }
+    length = fileLength;
+  }
+};
+
+// Makes the entries of directory, such as a renamed file, durable.
+inline void syncDirectory(const std::string &directory)
+{
+  int descriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (descriptor < 0)
+    throw fileError("Cannot open", directory);
+  int result = ::fsync(descriptor);
+  ::close(descriptor);
+  if (result != 0)
+    throw fileError("Cannot write", directory);
+}
+
+inline std::string directoryOf(const std::string &path)
+{
+  auto slash = path.find_last_of('/');
+  if (slash == std::string::npos)
+    return ".";
+  return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// Builds a flat file of size entries under a unique temporary name next to
+// path and renames it to path on commit(), so that readers never map a
+// half-written table, concurrent saves do not write over each other and a
+// failed save leaves the previous file in place.
+template <typename Key, typename Value>
+class FlatFileWriter
+{
+public:
+  using slot_type = FlatSlot<Key, Value>;
+
+  FlatFileWriter(const std::string &path, std::uint64_t size, std::uint64_t hashFingerprint)
+      : path(path), temporaryPath(path + ".XXXXXX"), slotCount(flatSlotCount(size)), size(size), written(0),
+        committed(false)
+  {
+    checkFlatTypes<Key, Value>();
+    try
+    {
+      file = FileMapping::createTemporary(temporaryPath, flatDataOffset + slotCount * sizeof(slot_type));
+    }
+    catch (...)
+    {
+      std::remove(temporaryPath.c_str());
+      throw;
+    }
+
+    FlatHeader header = {};
+    std::memcpy(header.magic, flatMagic, sizeof(header.magic));
+    header.version = flatVersion;
+    header.byteOrder = flatByteOrder;
+    header.keySize = sizeof(Key);
+    header.valueSize = sizeof(Value);
+    header.slotSize = sizeof(slot_type);
+    header.slotAlignment = alignof(slot_type);
+    header.hashFingerprint = hashFingerprint;
+    header.slotCount = slotCount;
+    header.size = size;
+    std::memcpy(file.bytes(), &header, sizeof(header));
+  }
+
+  FlatFileWriter(const FlatFileWriter &) = delete;
+  FlatFileWriter &operator=(const FlatFileWriter &) = delete;
+
+  ~FlatFileWriter()
+  {
+    if (!committed)
+      std::remove(temporaryPath.c_str());
+  }
+
+  // Keys have to be distinct; there must be no more of them than the size
+  // given to the constructor.
+  void insert(std::size_t hash, const Key &key, const Value &value)
+  {
+    if (written == size)
+      throw std::length_error("Writing more entries than announced to flat file");
+
+    auto tag = flatTag(hash);
+    auto slots = reinterpret_cast<slot_type *>(file.bytes() + flatDataOffset);
+    auto index = static_cast<std::size_t>(tag >> 1) & (slotCount - 1);
+    while (slots[index].tag != 0)
+      index = (index + 1) & (slotCount - 1);
+
+    slots[index].entry.first = key;
+    slots[index].entry.second = value;
+    slots[index].tag = tag;
+    ++written;
+  }
+
+  void commit()
+  {
+    file.flush(temporaryPath);
+    file = FileMapping();
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+      throw fileError("Cannot rename to", path);
+    committed = true;
+    // the rename itself is only durable once the directory is written
+    syncDirectory(directoryOf(path));
+  }
+
+private:
+  std::string path;
+  std::string temporaryPath;
+  std::uint64_t slotCount;
+  std::uint64_t size;
+  std::uint64_t written;
+  bool committed;
+  FileMapping file;
+};
+
+} // namespace detail
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_FLATHASHFILE_H */
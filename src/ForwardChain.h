@@ -0,0 +1,338 @@
+#ifndef AISDI_MAPS_FORWARDCHAIN_H
+#define AISDI_MAPS_FORWARDCHAIN_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace aisdi
+{
+
+// Singly linked bucket chain for HashMap, a drop-in for std::list there.
+// A bucket costs one pointer (std::list keeps a sentinel node and a size) and
+// every node one link. The link lives in the same allocation as the entry.
+// Operations that need the predecessor of a node (erase, splice, decrement)
+// walk the chain from its head, which is cheap because chains are short.
+template <typename T, typename Allocator = std::allocator<T>>
+class ForwardChain
+{
+  struct Node;
+  using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  ForwardChain() = default;
+
+  ForwardChain(const ForwardChain &other) : head(other.head)
+  {
+    head.first = nullptr;
+    Node **link = &head.first;
+    for (auto node = other.head.first; node != nullptr; node = node->next)
+    {
+      *link = createNode(node->value);
+      link = &(*link)->next;
+    }
+  }
+
+  ForwardChain(ForwardChain &&other) noexcept : head(std::move(other.head))
+  {
+    std::swap(head.first, other.head.first);
+  }
+
+  ForwardChain &operator=(const ForwardChain &other)
+  {
+    if (this != &other)
+    {
+      ForwardChain copy(other);
+      std::swap(head.first, copy.head.first);
+    }
+    return *this;
+  }
+
+  ForwardChain &operator=(ForwardChain &&other) noexcept
+  {
+    std::swap(head.first, other.head.first);
+    return *this;
+  }
+
+  ~ForwardChain()
+  {
+    while (head.first != nullptr)
+    {
+      auto node = head.first;
+      head.first = node->next;
+      destroyNode(node);
+    }
+  }
+
+  bool empty() const
+  {
+    return head.first == nullptr;
+  }
+
+  reference front()
+  {
+    return head.first->value;
+  }
+
+  const_reference front() const
+  {
+    return head.first->value;
+  }
+
+  template <typename... Args>
+  void emplace_front(Args &&... args)
+  {
+    auto node = createNode(std::forward<Args>(args)...);
+    node->next = head.first;
+    head.first = node;
+  }
+
+  iterator erase(const_iterator position)
+  {
+    auto node = position.node;
+    auto next = node->next;
+    *linkTo(node) = next;
+    destroyNode(node);
+    return iterator(this, next);
+  }
+
+  // Moves the node at it from other to just before position.
+  // Nodes are relinked, never copied, so references to the entry stay valid.
+  void splice(const_iterator position, ForwardChain &other, const_iterator it)
+  {
+    auto node = it.node;
+    *other.linkTo(node) = node->next;
+
+    auto link = linkTo(position.node);
+    node->next = *link;
+    *link = node;
+  }
+
+  iterator begin()
+  {
+    return iterator(this, head.first);
+  }
+
+  iterator end()
+  {
+    return iterator(this, nullptr);
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, head.first);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(this, nullptr);
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  const_iterator cend() const
+  {
+    return end();
+  }
+
+private:
+  struct Node
+  {
+    template <typename... Args>
+    explicit Node(Args &&... args) : value(std::forward<Args>(args)...)
+    {
+    }
+
+    Node *next = nullptr;
+    T value;
+  };
+
+  // Empty base optimization: a stateless allocator adds nothing to the chain.
+  struct Head : NodeAllocator
+  {
+    Head() = default;
+    Head(const Head &other) : NodeAllocator(NodeTraits::select_on_container_copy_construction(other)) {}
+    Head(Head &&other) noexcept : NodeAllocator(std::move(other)) {}
+
+    Node *first = nullptr;
+  };
+
+  Head head;
+
+  template <typename... Args>
+  Node *createNode(Args &&... args)
+  {
+    NodeAllocator &allocator = head;
+    auto node = NodeTraits::allocate(allocator, 1);
+    try
+    {
+      NodeTraits::construct(allocator, node, std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      NodeTraits::deallocate(allocator, node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  void destroyNode(Node *node)
+  {
+    NodeAllocator &allocator = head;
+    NodeTraits::destroy(allocator, node);
+    NodeTraits::deallocate(allocator, node, 1);
+  }
+
+  // The link pointing at node: the head or the next field of its predecessor.
+  // A null node gives the link past the last node.
+  Node **linkTo(const Node *node)
+  {
+    Node **link = &head.first;
+    while (*link != node)
+      link = &(*link)->next;
+    return link;
+  }
+};
+
+template <typename T, typename Allocator>
+class ForwardChain<T, Allocator>::ConstIterator
+{
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using reference = const T &;
+  using pointer = const T *;
+
+  ConstIterator() = default;
+
+  ConstIterator(const ForwardChain *chain, Node *node) : chain(chain), node(node)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    node = node->next;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    auto previous = chain->head.first;
+    while (previous->next != node)
+      previous = previous->next;
+    node = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    --*this;
+    return result;
+  }
+
+  reference operator*() const
+  {
+    return node->value;
+  }
+
+  pointer operator->() const
+  {
+    return &node->value;
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return node == other.node;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return node != other.node;
+  }
+
+private:
+  friend class ForwardChain;
+
+  const ForwardChain *chain = nullptr;
+  Node *node = nullptr;
+};
+
+template <typename T, typename Allocator>
+class ForwardChain<T, Allocator>::Iterator : public ForwardChain<T, Allocator>::ConstIterator
+{
+public:
+  using reference = T &;
+  using pointer = T *;
+
+  Iterator() = default;
+
+  Iterator(const ForwardChain *chain, Node *node) : ConstIterator(chain, node)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_FORWARDCHAIN_H */
@@ -0,0 +1,549 @@
+#ifndef AISDI_MAPS_FROZENHASHMAP_H
+#define AISDI_MAPS_FROZENHASHMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "HashMap.h"
+#include "HashUtils.h"
+
+namespace aisdi
+{
+namespace detail
+{
+
+// Runs task(i) for every i below count on up to threads threads, the calling
+// one included. Once a task throws the remaining ones are skipped and the
+// first exception is rethrown after every thread has finished.
+template <typename Task>
+void parallelFor(std::size_t count, unsigned threads, const Task &task)
+{
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto work = [&] {
+    for (auto i = next++; i < count && !failed; i = next++)
+    {
+      try
+      {
+        task(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < std::min<std::size_t>(threads, count); ++t)
+  {
+    try
+    {
+      workers.emplace_back(work);
+    }
+    catch (const std::system_error &)
+    {
+      break; // go on with the threads there are
+    }
+  }
+  work();
+  for (auto &worker : workers)
+    worker.join();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Maps a 32-bit hash onto [0, range) with a multiply instead of a modulo.
+inline std::uint32_t scaleHash(std::uint32_t hash, std::uint32_t range)
+{
+  return static_cast<std::uint32_t>((std::uint64_t(hash) * range) >> 32);
+}
+
+} // namespace detail
+
+// Immutable map over a fixed set of keys, for reference tables that are
+// loaded once and only read afterwards. The items sit in one array with no
+// empty slots and a minimal perfect hash function (PTHash, partitioned)
+// gives every key its own index in it: a lookup hashes the key, reads a few
+// bits of the function, then one item, and compares one key. A missing key
+// lands on some other key's item and fails that comparison.
+//
+// The function takes about 3 bits per key. Keys are split by hash into
+// partitions of a few thousand, each with its own function, and the
+// partitions are built in parallel. Distinct keys must not share a std::hash
+// value, as no function can tell them apart: the constructor throws
+// std::invalid_argument then. Of items with equal keys the first one is kept.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class FrozenHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+  using iterator = ConstIterator;
+
+  FrozenHashMap() = default;
+
+  // threads == 0 builds on every hardware thread.
+  template <typename InputIt>
+  FrozenHashMap(InputIt first, InputIt last, unsigned threads = 0, const Hash &hashFunction = Hash(),
+                const KeyEqual &keyEqual = KeyEqual())
+      : hashFunction(hashFunction), keyEqual(keyEqual)
+  {
+    build(std::vector<value_type>(first, last), threads);
+  }
+
+  FrozenHashMap(std::initializer_list<value_type> list) : FrozenHashMap(list.begin(), list.end())
+  {
+  }
+
+  template <typename IndexPolicy, bool StoreHash, typename Allocator, template <typename, typename> class Chain>
+  explicit FrozenHashMap(const HashMap<KeyType, ValueType, Hash, KeyEqual, IndexPolicy, StoreHash, Allocator, Chain> &map,
+                         unsigned threads = 0)
+      : FrozenHashMap(map.begin(), map.end(), threads)
+  {
+  }
+
+  bool isEmpty() const
+  {
+    return items.empty();
+  }
+
+  size_type getSize() const
+  {
+    return items.size();
+  }
+
+  bool contains(const key_type &key) const
+  {
+    return findItem(key) != nullptr;
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    auto item = findItem(key);
+    return item == nullptr ? end() : const_iterator(item, items.data() + items.size());
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    auto item = findItem(key);
+    if (item == nullptr)
+      throw std::out_of_range("Key does not exists");
+    return item->second;
+  }
+
+  // Memory taken by the hash function, everything but the items, per item.
+  double functionBitsPerKey() const
+  {
+    if (items.empty())
+      return 0;
+    auto bytes = pilotWords.size() * sizeof(std::uint64_t) + remap.size() * sizeof(std::uint32_t) +
+                 partitions.size() * sizeof(Partition);
+    return 8.0 * bytes / items.size();
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(items.data(), items.data() + items.size());
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(items.data() + items.size(), items.data() + items.size());
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  const_iterator cend() const
+  {
+    return end();
+  }
+
+private:
+  // Average number of keys per partition and per bucket, and how full the
+  // table of a partition is before its top slots are remapped (PTHash's alpha).
+  static const size_type partitionKeys = 4096;
+  static const size_type bucketKeys = 5;
+  static const size_type tableSlack = 100;
+  // 60% of the keys go to the first 30% of the buckets; placing those large
+  // buckets while the table is empty keeps the pilots small.
+  static const std::uint32_t denseThreshold = 0x9999999aU;
+
+  struct Partition
+  {
+    size_type firstItem;
+    size_type firstPilotBit;
+    size_type firstRemap;
+    std::uint64_t pilotMask;
+    std::uint32_t size;
+    std::uint32_t tableSize;
+    std::uint32_t denseBuckets;
+    std::uint32_t denseScale;
+    std::uint32_t sparseScale;
+    std::uint32_t pilotWidth;
+  };
+
+  // What one partition's build leaves behind until everything is packed.
+  struct PartitionBuild
+  {
+    size_type keyCount = 0;
+    std::vector<std::uint32_t> pilots;
+    std::vector<std::uint32_t> remap;
+  };
+
+  std::vector<value_type> items;
+  std::vector<Partition> partitions;
+  // pilots of all partitions packed back to back, plus a word of padding
+  std::vector<std::uint64_t> pilotWords;
+  // item index for every slot past the size of its partition's table
+  std::vector<std::uint32_t> remap;
+  Hash hashFunction;
+  KeyEqual keyEqual;
+
+  const value_type *findItem(const key_type &key) const
+  {
+    if (items.empty())
+      return nullptr;
+
+    auto h = detail::mixHash(hashFunction(key));
+    auto &partition = partitions[detail::scaleHash(static_cast<std::uint32_t>(h >> 32),
+                                                   static_cast<std::uint32_t>(partitions.size()))];
+    auto slot = slotOf(partition, h, detail::mixHash(pilotAt(partition, bucketOf(partition, h))));
+    auto index = slot < partition.size ? partition.firstItem + slot : remap[partition.firstRemap + slot - partition.size];
+
+    auto item = items.data() + index;
+    return keyEqual(item->first, key) ? item : nullptr;
+  }
+
+  // Low half of the hash picks the bucket, the high half the partition.
+  static std::uint32_t bucketOf(const Partition &partition, std::uint64_t h)
+  {
+    auto bucketHash = static_cast<std::uint32_t>(h);
+    auto dense = static_cast<std::uint32_t>((std::uint64_t(bucketHash) * partition.denseScale) >> 32);
+    auto sparse = partition.denseBuckets +
+                  static_cast<std::uint32_t>((std::uint64_t(bucketHash - denseThreshold) * partition.sparseScale) >> 32);
+    return bucketHash < denseThreshold ? dense : sparse;
+  }
+
+  static std::uint32_t slotOf(const Partition &partition, std::uint64_t h, std::uint64_t pilotHash)
+  {
+    auto slotHash = detail::mixHash(h ^ pilotHash);
+    return detail::scaleHash(static_cast<std::uint32_t>(slotHash >> 32), partition.tableSize);
+  }
+
+  std::uint64_t pilotAt(const Partition &partition, std::uint32_t bucket) const
+  {
+    auto bit = partition.firstPilotBit + size_type(bucket) * partition.pilotWidth;
+    auto word = bit / 64;
+    auto shift = bit % 64;
+    auto bits = (pilotWords[word] >> shift) | (pilotWords[word + 1] << 1 << (63 - shift));
+    return bits & partition.pilotMask;
+  }
+
+  void build(std::vector<value_type> &&source, unsigned threads)
+  {
+    if (source.empty())
+      return;
+    if (source.size() > std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("Too many items to freeze");
+    if (threads == 0)
+      threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    const auto count = source.size();
+    const auto chunk = size_type(1) << 16;
+    std::vector<std::uint64_t> hashes(count);
+    detail::parallelFor((count + chunk - 1) / chunk, threads, [&](size_type c) {
+      for (auto i = c * chunk; i < std::min(count, (c + 1) * chunk); ++i)
+        hashes[i] = detail::mixHash(hashFunction(source[i].first));
+    });
+
+    // group the items by partition, in a counting sort
+    partitions.resize((count + partitionKeys - 1) / partitionKeys);
+    std::vector<size_type> partitionStart(partitions.size() + 1, 0);
+    std::vector<std::uint32_t> order(count);
+    for (auto h : hashes)
+      ++partitionStart[partitionOf(h) + 1];
+    std::partial_sum(partitionStart.begin(), partitionStart.end(), partitionStart.begin());
+    {
+      auto fill = partitionStart;
+      for (std::uint32_t i = 0; i < count; ++i)
+        order[fill[partitionOf(hashes[i])]++] = i;
+    }
+
+    std::vector<PartitionBuild> builds(partitions.size());
+    detail::parallelFor(partitions.size(), threads, [&](size_type p) {
+      auto first = order.begin() + partitionStart[p];
+      builds[p].keyCount = dropDuplicates(first, order.begin() + partitionStart[p + 1], source, hashes);
+    });
+
+    size_type firstItem = 0;
+    for (size_type p = 0; p < partitions.size(); ++p)
+    {
+      partitions[p].firstItem = firstItem;
+      firstItem += builds[p].keyCount;
+    }
+
+    // slot index -> source index, every partition fills its own range
+    std::vector<std::uint32_t> itemOf(firstItem);
+    detail::parallelFor(partitions.size(), threads, [&](size_type p) {
+      buildPartition(partitions[p], builds[p], order.data() + partitionStart[p], hashes, itemOf);
+    });
+
+    packPilots(builds);
+    items.reserve(itemOf.size());
+    for (auto index : itemOf)
+      items.push_back(std::move(source[index]));
+  }
+
+  size_type partitionOf(std::uint64_t h) const
+  {
+    return detail::scaleHash(static_cast<std::uint32_t>(h >> 32), static_cast<std::uint32_t>(partitions.size()));
+  }
+
+  // Sorts a partition's items by hash and removes all but the first of equal
+  // keys. Returns how many are left at the front of the range.
+  size_type dropDuplicates(std::vector<std::uint32_t>::iterator first, std::vector<std::uint32_t>::iterator last,
+                           const std::vector<value_type> &source, const std::vector<std::uint64_t> &hashes) const
+  {
+    std::sort(first, last, [&](std::uint32_t lhs, std::uint32_t rhs) {
+      return hashes[lhs] != hashes[rhs] ? hashes[lhs] < hashes[rhs] : lhs < rhs;
+    });
+    auto kept = first;
+    for (auto it = first; it != last; ++it)
+    {
+      if (kept != first && hashes[*(kept - 1)] == hashes[*it])
+      {
+        if (!keyEqual(source[*(kept - 1)].first, source[*it].first))
+          throw std::invalid_argument("Distinct keys with equal hashes cannot be frozen");
+        continue;
+      }
+      *kept++ = *it;
+    }
+    return static_cast<size_type>(kept - first);
+  }
+
+  // Finds a pilot for every bucket of the partition, largest buckets first:
+  // the first one that sends all its keys to free slots, none of them twice.
+  void buildPartition(Partition &partition, PartitionBuild &build, const std::uint32_t *keys,
+                      const std::vector<std::uint64_t> &hashes, std::vector<std::uint32_t> &itemOf) const
+  {
+    const auto size = static_cast<std::uint32_t>(build.keyCount);
+    const auto bucketCount = std::max<std::uint32_t>(static_cast<std::uint32_t>((size + bucketKeys - 1) / bucketKeys), 2);
+    partition.size = size;
+    partition.tableSize = static_cast<std::uint32_t>(size + size / tableSlack + 1);
+    partition.denseBuckets = std::max<std::uint32_t>(bucketCount * 3 / 10, 1);
+    partition.denseScale = static_cast<std::uint32_t>((std::uint64_t(partition.denseBuckets) << 32) / denseThreshold);
+    partition.sparseScale = static_cast<std::uint32_t>((std::uint64_t(bucketCount - partition.denseBuckets) << 32) /
+                                                       ((std::uint64_t(1) << 32) - denseThreshold));
+
+    // keys of every bucket next to each other, buckets ordered by size
+    std::vector<std::uint32_t> bucketStart(bucketCount + 1, 0);
+    std::vector<std::uint32_t> bucketOfKey(size);
+    for (std::uint32_t k = 0; k < size; ++k)
+    {
+      bucketOfKey[k] = bucketOf(partition, hashes[keys[k]]);
+      ++bucketStart[bucketOfKey[k] + 1];
+    }
+    std::partial_sum(bucketStart.begin(), bucketStart.end(), bucketStart.begin());
+    std::vector<std::uint32_t> bucketKeysOrder(size);
+    {
+      auto fill = bucketStart;
+      for (std::uint32_t k = 0; k < size; ++k)
+        bucketKeysOrder[fill[bucketOfKey[k]]++] = k;
+    }
+    std::vector<std::uint32_t> buckets(bucketCount);
+    for (std::uint32_t b = 0; b < bucketCount; ++b)
+      buckets[b] = b;
+    std::stable_sort(buckets.begin(), buckets.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+      return bucketStart[lhs + 1] - bucketStart[lhs] > bucketStart[rhs + 1] - bucketStart[rhs];
+    });
+
+    std::vector<bool> taken(partition.tableSize, false);
+    std::vector<std::uint32_t> slotOfKey(size);
+    std::vector<std::uint64_t> bucketHashes;
+    std::vector<std::uint32_t> slots;
+    build.pilots.assign(bucketCount, 0);
+    for (auto bucket : buckets)
+    {
+      const auto first = bucketStart[bucket];
+      const auto last = bucketStart[bucket + 1];
+      if (first == last)
+        break;
+
+      bucketHashes.clear();
+      for (auto k = first; k < last; ++k)
+        bucketHashes.push_back(hashes[keys[bucketKeysOrder[k]]]);
+      for (std::uint32_t pilot = 0;; ++pilot)
+      {
+        const auto pilotHash = detail::mixHash(pilot);
+        slots.clear();
+        for (auto h : bucketHashes)
+        {
+          auto slot = slotOf(partition, h, pilotHash);
+          if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+            break;
+          slots.push_back(slot);
+        }
+        if (slots.size() == bucketHashes.size())
+        {
+          for (auto k = first; k < last; ++k)
+          {
+            slotOfKey[bucketKeysOrder[k]] = slots[k - first];
+            taken[slots[k - first]] = true;
+          }
+          build.pilots[bucket] = pilot;
+          break;
+        }
+      }
+    }
+
+    // slots past size get the free ones below it, in order; the others point
+    // at item 0, which exists, so that a missing key has something to compare
+    build.remap.assign(partition.tableSize - size, 0);
+    std::uint32_t free = 0;
+    for (std::uint32_t slot = size; slot < partition.tableSize; ++slot)
+    {
+      if (!taken[slot])
+        continue;
+      while (taken[free])
+        ++free;
+      build.remap[slot - size] = static_cast<std::uint32_t>(partition.firstItem + free++);
+    }
+    for (std::uint32_t k = 0; k < size; ++k)
+    {
+      auto slot = slotOfKey[k];
+      auto index = slot < size ? partition.firstItem + slot : build.remap[slot - size];
+      itemOf[index] = keys[k];
+    }
+  }
+
+  void packPilots(const std::vector<PartitionBuild> &builds)
+  {
+    size_type bits = 0;
+    size_type remapCount = 0;
+    for (size_type p = 0; p < partitions.size(); ++p)
+    {
+      auto largest = *std::max_element(builds[p].pilots.begin(), builds[p].pilots.end());
+      auto width = largest == 0 ? 0u : detail::highestBitIndex(largest) + 1;
+      partitions[p].firstPilotBit = bits;
+      partitions[p].pilotWidth = width;
+      partitions[p].pilotMask = (std::uint64_t(1) << width) - 1;
+      partitions[p].firstRemap = remapCount;
+      bits += builds[p].pilots.size() * width;
+      remapCount += builds[p].remap.size();
+    }
+
+    pilotWords.assign(bits / 64 + 2, 0);
+    remap.reserve(remapCount);
+    for (size_type p = 0; p < partitions.size(); ++p)
+    {
+      auto bit = partitions[p].firstPilotBit;
+      for (std::uint64_t pilot : builds[p].pilots)
+      {
+        pilotWords[bit / 64] |= pilot << (bit % 64);
+        if (bit % 64 + partitions[p].pilotWidth > 64)
+          pilotWords[bit / 64 + 1] |= pilot >> (64 - bit % 64);
+        bit += partitions[p].pilotWidth;
+      }
+      remap.insert(remap.end(), builds[p].remap.begin(), builds[p].remap.end());
+    }
+  }
+};
+
+// Forward iterator over the items, in no particular order.
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+class FrozenHashMap<KeyType, ValueType, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename FrozenHashMap::const_reference;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename FrozenHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+
+  ConstIterator() : item(nullptr), last(nullptr)
+  {
+  }
+
+  ConstIterator(const value_type *item, const value_type *last) : item(item), last(last)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (item == last)
+      throw std::out_of_range("Incrementing end iterator");
+    ++item;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (item == last)
+      throw std::out_of_range("Dereferencing end iterator");
+    return *item;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return item == other.item;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  const value_type *item;
+  const value_type *last;
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_FROZENHASHMAP_H */
@@ -1,256 +1,1647 @@
 #ifndef AISDI_MAPS_HASHMAP_H
 #define AISDI_MAPS_HASHMAP_H
 
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <list>
+#include <memory>
 #include <algorithm>
 
+#include "BloomFilter.h"
+#include "ForwardChain.h"
+#include "HashUtils.h"
+#include "MapTraits.h"
+#include "PoolAllocator.h"
+#include "TreeMap.h"
+
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class HashMap
-{
-public:
-  using key_type = KeyType;
-  using mapped_type = ValueType;
-  using value_type = std::pair<key_type, mapped_type>;
-  using size_type = std::size_t;
-  using reference = value_type &;
-  using const_reference = const value_type &;
-  using list_type = std::list<value_type>;
-  using table_type = std::vector<list_type>;
+// Immediate: growing rehashes the whole table inside the insert that crossed the threshold.
+// Incremental: the old table is kept and drained a few buckets per insert / remove.
+enum class RehashMode
+{
+  Immediate,
+  Incremental
+};
+
+namespace detail
+{
+
+// Element of a HashMap bucket list. With StoreHash the full hash of the key
+// is kept next to the pair, so resizing never calls the hasher again and
+// lookups skip most non-matching entries without comparing keys.
+// Stored is the StoredValue that tells where the key is in Value.
+template <typename Value, typename Stored, bool StoreHash>
+struct HashMapEntry
+{
+  template <typename... Args>
+  explicit HashMapEntry(std::size_t, Args &&... args) : value(std::forward<Args>(args)...)
+  {
+  }
+
+  template <typename Hash>
+  std::size_t hash(const Hash &hashFunction) const
+  {
+    return hashFunction(Stored::keyOf(value));
+  }
+
+  bool hashEquals(std::size_t) const
+  {
+    return true;
+  }
+
+  void setHash(std::size_t)
+  {
+  }
+
+  Value value;
+};
+
+template <typename Value, typename Stored>
+struct HashMapEntry<Value, Stored, true>
+{
+  template <typename... Args>
+  explicit HashMapEntry(std::size_t hash, Args &&... args) : value(std::forward<Args>(args)...), storedHash(hash)
+  {
+  }
+
+  template <typename Hash>
+  std::size_t hash(const Hash &) const
+  {
+    return storedHash;
+  }
+
+  bool hashEquals(std::size_t hash) const
+  {
+    return storedHash == hash;
+  }
+
+  // for an entry moved in from a map whose hash function may differ
+  void setHash(std::size_t hash)
+  {
+    storedHash = hash;
+  }
+
+  Value value;
+  std::size_t storedHash;
+};
+
+} // namespace detail
+
+// Allocator is rebound to the chain nodes and to the bucket array. It has to
+// be stateless: the map default-constructs it wherever it needs one.
+// Chain is the bucket list template, std::list or the leaner ForwardChain.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>,
+          typename IndexPolicy = PowerOfTwoIndexing,
+          bool StoreHash = false,
+          typename Allocator = std::allocator<std::pair<KeyType, ValueType>>,
+          template <typename, typename> class Chain = std::list>
+class HashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = typename detail::StoredValue<key_type, mapped_type>::type;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using entry_type = detail::HashMapEntry<value_type, detail::StoredValue<key_type, mapped_type>, StoreHash>;
+  using list_type = Chain<entry_type, typename std::allocator_traits<Allocator>::template rebind_alloc<entry_type>>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  // Owns an entry taken out by extract(), still in its list node, until it is
+  // inserted into a map of the same type or the handle is destroyed.
+  class NodeHandle
+  {
+  public:
+    NodeHandle() = default;
+    NodeHandle(NodeHandle &&) = default;
+    NodeHandle &operator=(NodeHandle &&) = default;
+
+    bool empty() const
+    {
+      return node.empty();
+    }
+
+    explicit operator bool() const
+    {
+      return !empty();
+    }
+
+    const key_type &key() const
+    {
+      return detail::StoredValue<key_type, mapped_type>::keyOf(node.front().value);
+    }
+
+    mapped_type &mapped()
+    {
+      return node.front().value.second;
+    }
+
+  private:
+    friend class HashMap;
+
+    // no node or exactly one
+    list_type node;
+  };
+
+  using node_type = NodeHandle;
+
+  struct insert_return_type
+  {
+    iterator position;
+    bool inserted;
+    node_type node;
+  };
+
+private:
+  template <typename K>
+  using EnableIfTransparent = typename std::enable_if<detail::IsTransparent<Hash>::value &&
+                                                      detail::IsTransparent<KeyEqual>::value &&
+                                                      !std::is_convertible<K, const_iterator>::value>::type;
+
+public:
+  HashMap() : HashMap(Hash())
+  {
+  }
+
+  explicit HashMap(const Hash &hashFunction, const KeyEqual &keyEqual = KeyEqual())
+      : table(initialBucketsNumber), buckets(initialBucketsNumber), size(0),
+        hashFunction(hashFunction), keyEqual(keyEqual)
+  {
+    table.create(0, buckets);
+  }
+
+  // The table is sized for the whole list up front, so building never rehashes.
+  // Of duplicate keys the first one is kept, as by insert(first, last).
+  HashMap(std::initializer_list<value_type> list)
+  {
+    const auto s = IndexPolicy::bucketCount(std::max(minimumBuckets(list.size()), size_type(initialBucketsNumber)));
+    table = BucketArray(s);
+    table.create(0, s);
+    buckets = s;
+
+    for (auto &item : list)
+    {
+      auto h = hash(item.first);
+      auto &bucket = table[bucketIndex(h, buckets)];
+      auto it = findKeyInList(item.first, h, bucket);
+      if (it == bucket.end())
+      {
+        bucket.emplace_front(h, item);
+        chainInserted(bucket, h);
+        ++size;
+      }
+    }
+    for (size_type i = 0; i < s; ++i)
+      table.updateOccupied(i);
+    firstBucket = nextNonEmptyBucket(0);
+  }
+
+  HashMap(const HashMap &other)
+      : table(other.table.size()), oldTable(other.oldTable.size()), buckets(other.buckets),
+        size(other.size), migratedBuckets(other.migratedBuckets), firstBucket(other.firstBucket),
+        bloomFilter(other.bloomFilter), nextBloomFilter(other.nextBloomFilter), bloomFilterEnabled(other.bloomFilterEnabled),
+        removedSinceBloomBuild(other.removedSinceBloomBuild), rehashMode(other.rehashMode),
+        maxLoadFactor(other.maxLoadFactor), hashFunction(other.hashFunction), keyEqual(other.keyEqual)
+  {
+    for (size_type i = 0; i < virtualBucketCount(); ++i)
+    {
+      if (isLive(i))
+        bucketStorage(i).create(localIndex(i), other.bucketAt(i));
+    }
+    treeifyLongChains();
+  }
+
+  HashMap(HashMap &&other) noexcept
+  {
+    swap(other);
+  }
+
+  HashMap &operator=(const HashMap &other)
+  {
+    if (this != &other)
+    {
+      HashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  HashMap &operator=(HashMap &&other) noexcept
+  {
+    if (this != &other)
+    {
+      destroyBuckets();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~HashMap()
+  {
+    destroyBuckets();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type &operator[](const key_type &key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  mapped_type &operator[](key_type &&key)
+  {
+    return tryEmplace(std::move(key)).first->second;
+  }
+
+  // Inserts a value constructed from args unless the key is already present,
+  // in which case args are left untouched. The key is copied or moved once.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+  {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+  {
+    return insertOrAssign(key, std::forward<M>(value));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+  {
+    return insertOrAssign(std::move(key), std::forward<M>(value));
+  }
+
+  // The key is only known once the pair is built, so args go into a
+  // temporary value_type whose members are then moved into the node.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return tryEmplace(std::move(value.first), std::move(value.second));
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    return constValueOf(key);
+  }
+
+  mapped_type &valueOf(const key_type &key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type &>(constValueOf(key));
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    return constIteratorFind(key);
+  }
+
+  iterator find(const key_type &key)
+  {
+    return iterator(constIteratorFind(key));
+  }
+
+  void remove(const key_type &key)
+  {
+    removeKey(key);
+  }
+
+  // Heterogeneous lookup: when both Hash and KeyEqual are transparent, any type
+  // they accept can be used as a key without building a key_type first.
+  template <typename K, typename = EnableIfTransparent<K>>
+  const mapped_type &valueOf(const K &key) const
+  {
+    return constValueOf(key);
+  }
+
+  template <typename K, typename = EnableIfTransparent<K>>
+  mapped_type &valueOf(const K &key)
+  {
+    return const_cast<mapped_type &>(constValueOf(key));
+  }
+
+  template <typename K, typename = EnableIfTransparent<K>>
+  const_iterator find(const K &key) const
+  {
+    return constIteratorFind(key);
+  }
+
+  template <typename K, typename = EnableIfTransparent<K>>
+  iterator find(const K &key)
+  {
+    return iterator(constIteratorFind(key));
+  }
+
+  template <typename K, typename = EnableIfTransparent<K>>
+  void remove(const K &key)
+  {
+    removeKey(key);
+  }
+
+  // Looks up every key of the forward range [first, last) and writes one
+  // iterator per key to out (end() for missing keys), in the order of the keys.
+  // Keys are processed in batches: all of them are hashed and their buckets and
+  // chain heads prefetched before the first is resolved, so that the cache
+  // misses of a batch overlap instead of following one another.
+  template <typename KeyIterator, typename OutputIterator>
+  OutputIterator findMany(KeyIterator first, KeyIterator last, OutputIterator out) const
+  {
+    findBatched(first, last, [&out](const const_iterator &it) { *out++ = it; });
+    return out;
+  }
+
+  template <typename KeyIterator, typename OutputIterator>
+  OutputIterator findMany(KeyIterator first, KeyIterator last, OutputIterator out)
+  {
+    findBatched(first, last, [&out](const const_iterator &it) { *out++ = iterator(it); });
+    return out;
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    unlink(it);
+    migrateStep();
+  }
+
+  // Removes the item at it and returns the position of the item after it,
+  // so that items can be removed while iterating. Unlike remove(), it never
+  // advances an incremental migration, which would move items still ahead.
+  iterator erase(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    auto next = it;
+    ++next;
+    unlink(it);
+    return iterator(next);
+  }
+
+  // Removes every item for which pred(item) holds, in one pass over the
+  // buckets, without hashing or looking up any key. Returns how many items
+  // were removed.
+  template <typename Predicate>
+  size_type erase_if(Predicate pred)
+  {
+    const auto before = size;
+    auto bucket = nextNonEmptyBucket(0);
+    try
+    {
+      for (; bucket < virtualBucketCount(); bucket = nextNonEmptyBucket(bucket + 1))
+      {
+        auto &list = bucketAt(bucket);
+        // cheaper to drop a chain tree and build it again than to keep it in step
+        untreeify(list);
+        for (auto it = list.begin(); it != list.end();)
+        {
+          if (pred(static_cast<const value_type &>(it->value)))
+          {
+            it = list.erase(it);
+            --size;
+          }
+          else
+            ++it;
+        }
+        treeifyIfLong(list);
+        bucketRemoved(bucket);
+      }
+    }
+    catch (...)
+    {
+      bucketRemoved(bucket);
+      bloomRemoved(before - size);
+      throw;
+    }
+    bloomRemoved(before - size);
+    return before - size;
+  }
+
+  // Inserts the items of [first, last) whose keys are not in the map yet; of
+  // equal keys in the range the first one wins. A forward range is counted,
+  // so the table grows at most once, and all its keys are hashed before the
+  // items are put in bucket order, walking the bucket array once instead of
+  // jumping around it.
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    insertRange(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+  }
+
+  // Unlinks the entry of key and hands over its node; the handle is empty if
+  // there is no such key. Nothing is allocated, freed, copied or moved.
+  node_type extract(const key_type &key)
+  {
+    auto it = constIteratorFind(key);
+    return it == cend() ? node_type() : extractAt(it);
+  }
+
+  node_type extract(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Extracting end iterator");
+    return extractAt(it);
+  }
+
+  // Links the node of handle into the map unless its key is already present,
+  // in which case the handle is given back in the result. An empty handle
+  // inserts nothing.
+  insert_return_type insert(node_type &&handle)
+  {
+    if (handle.empty())
+      return { end(), false, node_type() };
+
+    ensureTable();
+    const auto h = hash(handle.key());
+    auto it = bloomRulesOut(h) ? cend() : findWithHash(handle.key(), h);
+    if (it != cend())
+      return { iterator(it), false, std::move(handle) };
+    return { linkNode(handle, h), true, node_type() };
+  }
+
+  // Moves every entry of source whose key is not in this map over here, by
+  // relinking its node; entries with keys present in both stay in source.
+  void merge(HashMap &source)
+  {
+    if (&source == this)
+      return;
+
+    // source must not move its nodes between buckets under the iteration
+    source.migrateBuckets(source.oldTable.size());
+    ensureTable();
+    for (auto it = source.cbegin(); it != source.cend();)
+    {
+      auto current = it;
+      ++it;
+      const auto &key = detail::StoredValue<key_type, mapped_type>::keyOf(*current);
+      const auto h = hash(key);
+      if (!bloomRulesOut(h) && findWithHash(key, h) != cend())
+        continue;
+
+      auto handle = source.extractAt(current);
+      linkNode(handle, h);
+    }
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  RehashMode getRehashMode() const
+  {
+    return rehashMode;
+  }
+
+  // Switching back to Immediate finishes a migration that is in progress.
+  void setRehashMode(RehashMode mode)
+  {
+    rehashMode = mode;
+    if (mode == RehashMode::Immediate)
+      migrateBuckets(oldTable.size());
+  }
+
+  bool isRehashing() const
+  {
+    return oldTable.size() != 0;
+  }
+
+  // With the filter on, lookups first ask a blocked Bloom filter of the keys
+  // (see BloomFilter.h), and a key it rules out costs no bucket or node
+  // access. Worth it when most lookups miss; takes 1.5 bytes per bucket.
+  // The filter is rebuilt with the table and after enough removals.
+  void setBloomFilter(bool enabled)
+  {
+    bloomFilterEnabled = enabled;
+    if (enabled)
+      rebuildBloomFilter();
+    else
+      bloomFilter = nextBloomFilter = detail::BlockedBloomFilter();
+  }
+
+  bool hasBloomFilter() const
+  {
+    return bloomFilterEnabled;
+  }
+
+  size_type bucket_count() const
+  {
+    return buckets;
+  }
+
+  float load_factor() const
+  {
+    return buckets == 0 ? 0.0f : static_cast<float>(size) / buckets;
+  }
+
+  float max_load_factor() const
+  {
+    return maxLoadFactor;
+  }
+
+  // Rehashes right away if the current size already exceeds the new limit.
+  void max_load_factor(float factor)
+  {
+    if (!(factor > 0.0f))
+      throw std::invalid_argument("Max load factor has to be positive");
+
+    maxLoadFactor = factor;
+    if (size > maximumSize())
+      rehash(0);
+  }
+
+  // Sets the number of buckets to at least count, and to at least as many
+  // as the current size needs under max_load_factor(). May shrink the table.
+  // Always rehashes immediately, finishing an incremental migration first.
+  void rehash(size_type count)
+  {
+    auto newBuckets = IndexPolicy::bucketCount(std::max(std::max(count, minimumBuckets(size)), size_type(1)));
+    if (newBuckets != buckets || isRehashing())
+      rehashTo(newBuckets);
+  }
+
+  // Makes room for count elements, so that inserting up to count keys does not
+  // trigger any further rehash. Never shrinks the table.
+  void reserve(size_type count)
+  {
+    if (minimumBuckets(count) > buckets)
+      rehash(minimumBuckets(count));
+  }
+
+  hasher hash_function() const
+  {
+    return hashFunction;
+  }
+
+  bool operator==(const HashMap &other) const
+  {
+    for (auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return size == other.size;
+  }
+
+  bool operator!=(const HashMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    if (size == 0)
+      return cend();
+
+    return const_iterator(this, firstBucket, bucketAt(firstBucket).begin());
+  }
+
+  const_iterator cend() const
+  {
+    return const_iterator(this, virtualBucketCount(), typename list_type::const_iterator());
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  // Keys with an operator< that agrees with KeyEqual are ordered by it where
+  // their hashes are equal, like Comparable keys in Java's HashMap. Other keys
+  // of one hash share a group that is searched linearly.
+  using OrderedKeys = std::integral_constant<bool, detail::IsLessComparable<key_type>::value &&
+                                                       (std::is_same<KeyEqual, std::equal_to<key_type>>::value ||
+                                                        std::is_same<KeyEqual, std::equal_to<>>::value)>;
+
+  // Full hash and key of a chain entry; the key is only looked at for OrderedKeys.
+  using ChainKey = std::pair<std::size_t, const key_type *>;
+
+  struct ChainOrder
+  {
+    bool operator()(const ChainKey &a, const ChainKey &b) const
+    {
+      if (a.first != b.first)
+        return a.first < b.first;
+      return keysLess(a, b, OrderedKeys());
+    }
+
+    static bool keysLess(const ChainKey &a, const ChainKey &b, std::true_type)
+    {
+      return *a.second < *b.second;
+    }
+
+    static bool keysLess(const ChainKey &, const ChainKey &, std::false_type)
+    {
+      return false;
+    }
+  };
+
+  // Entries of a treeified chain that the order cannot tell apart, mostly one.
+  using EntryGroup = std::vector<typename list_type::iterator>;
+  using ChainTree = TreeMap<ChainKey, EntryGroup, ChainOrder>;
+  using ChainTrees = TreeMap<const list_type *, ChainTree>;
+
+  // Raw storage for a row of bucket lists. Lists are created and destroyed
+  // explicitly by the owner, so that a migration can build the new table and
+  // tear down the old one a few buckets at a time.
+  // Next to the lists it keeps one bit per bucket, set while the bucket holds
+  // anything, so that iteration skips 64 empty buckets at a time without
+  // touching their list headers. The owner updates the bit after each change.
+  class BucketArray
+  {
+    using ArrayAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<list_type>;
+    using ArrayTraits = std::allocator_traits<ArrayAllocator>;
+    using Word = std::uint64_t;
+    using WordAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Word>;
+    using WordTraits = std::allocator_traits<WordAllocator>;
+
+    static const size_type wordBits = 64;
+
+  public:
+    explicit BucketArray(size_type count = 0)
+        : count(count), lists(count ? allocate(count) : nullptr), occupied(count ? allocateWords(count) : nullptr)
+    {
+    }
+
+    BucketArray(const BucketArray &) = delete;
+    BucketArray &operator=(const BucketArray &) = delete;
+
+    BucketArray(BucketArray &&other) noexcept
+    {
+      std::swap(count, other.count);
+      std::swap(lists, other.lists);
+      std::swap(occupied, other.occupied);
+    }
+
+    BucketArray &operator=(BucketArray &&other) noexcept
+    {
+      std::swap(count, other.count);
+      std::swap(lists, other.lists);
+      std::swap(occupied, other.occupied);
+      return *this;
+    }
+
+    // every list has to be destroyed by the owner beforehand
+    ~BucketArray()
+    {
+      if (lists != nullptr)
+      {
+        ArrayAllocator allocator;
+        ArrayTraits::deallocate(allocator, lists, count);
+        WordAllocator wordAllocator;
+        WordTraits::deallocate(wordAllocator, occupied, wordsNumber(count));
+      }
+    }
+
+    void create(size_type first, size_type last)
+    {
+      for (auto i = first; i < last; ++i)
+        new (lists + i) list_type();
+    }
+
+    void create(size_type index, const list_type &source)
+    {
+      new (lists + index) list_type(source);
+      updateOccupied(index);
+    }
+
+    void destroy(size_type first, size_type last)
+    {
+      for (auto i = first; i < last; ++i)
+      {
+        lists[i].~list_type();
+        occupied[i / wordBits] &= ~(Word(1) << (i % wordBits));
+      }
+    }
+
+    void updateOccupied(size_type index)
+    {
+      const auto bit = Word(1) << (index % wordBits);
+      if (lists[index].empty())
+        occupied[index / wordBits] &= ~bit;
+      else
+        occupied[index / wordBits] |= bit;
+    }
+
+    // First non-empty bucket at or after first, size() if there is none.
+    size_type nextOccupied(size_type first) const
+    {
+      if (first >= count)
+        return count;
+
+      auto word = first / wordBits;
+      auto bits = occupied[word] & (~Word(0) << (first % wordBits));
+      while (bits == 0)
+      {
+        if (++word == wordsNumber(count))
+          return count;
+        bits = occupied[word];
+      }
+      return word * wordBits + detail::countTrailingZeros(bits);
+    }
+
+    // Last non-empty bucket before last, size() if there is none.
+    size_type previousOccupied(size_type last) const
+    {
+      if (last == 0)
+        return count;
+
+      auto word = (last - 1) / wordBits;
+      auto bits = occupied[word] & (~Word(0) >> (wordBits - 1 - (last - 1) % wordBits));
+      while (bits == 0)
+      {
+        if (word-- == 0)
+          return count;
+        bits = occupied[word];
+      }
+      return word * wordBits + detail::highestBitIndex(bits);
+    }
+
+    list_type &operator[](size_type index)
+    {
+      return lists[index];
+    }
+
+    const list_type &operator[](size_type index) const
+    {
+      return lists[index];
+    }
+
+    size_type size() const
+    {
+      return count;
+    }
+
+  private:
+    size_type count = 0;
+    list_type *lists = nullptr;
+    Word *occupied = nullptr;
+
+    static size_type wordsNumber(size_type count)
+    {
+      return (count + wordBits - 1) / wordBits;
+    }
+
+    static list_type *allocate(size_type count)
+    {
+      ArrayAllocator allocator;
+      return ArrayTraits::allocate(allocator, count);
+    }
+
+    static Word *allocateWords(size_type count)
+    {
+      WordAllocator allocator;
+      auto words = WordTraits::allocate(allocator, wordsNumber(count));
+      std::fill(words, words + wordsNumber(count), Word(0));
+      return words;
+    }
+  };
+
+  // Buckets are addressed by a single "virtual" number: while migrating,
+  // numbers [0, oldTable.size()) belong to the old table and the new table
+  // follows them. Otherwise the old table is empty and numbers map directly.
+  BucketArray table;
+  BucketArray oldTable;
+  size_type buckets = 0;
+  size_type size = 0;
+  size_type migratedBuckets = 0;
+  // first non-empty bucket while the map is not empty, kept up to date so
+  // that begin() never searches
+  size_type firstBucket = 0;
+  // Every std::list chain of treeifyThreshold or more entries gets a search
+  // tree over them, ordered by full hash (see ChainOrder), so that a weak or
+  // attacked hash function costs logarithmic rather than linear lookups.
+  // Trees are keyed by the chain's address, which stays put until its table
+  // is freed.
+  ChainTrees chainTrees;
+  // Keys of both tables. While migrating, nextBloomFilter is built for the
+  // new table from the nodes moved there and the keys inserted meanwhile.
+  detail::BlockedBloomFilter bloomFilter;
+  detail::BlockedBloomFilter nextBloomFilter;
+  bool bloomFilterEnabled = false;
+  size_type removedSinceBloomBuild = 0;
+  RehashMode rehashMode = RehashMode::Immediate;
+  float maxLoadFactor = 1.0f;
+  Hash hashFunction;
+  KeyEqual keyEqual;
+
+  static const size_type initialBucketsNumber = 8;
+  static const size_type treeifyThreshold = 8;
+  // below it a tree is dropped; the gap keeps a chain hovering at the
+  // threshold from building and dropping its tree over and over
+  static const size_type untreeifyThreshold = 6;
+  static const size_type migrationStep = 2;
+  // enough lookups in flight to cover memory latency, few enough to stay in L1
+  static const size_type findBatchSize = 16;
+
+  template <typename K>
+  std::size_t hash(const K &key) const
+  {
+    return hashFunction(key);
+  }
+
+  // Largest size the current bucket count holds without exceeding maxLoadFactor.
+  double maximumSize() const
+  {
+    return static_cast<double>(buckets) * maxLoadFactor;
+  }
+
+  // Fewest buckets that keep count elements within maxLoadFactor.
+  size_type minimumBuckets(size_type count) const
+  {
+    auto result = static_cast<size_type>(std::ceil(count / static_cast<double>(maxLoadFactor)));
+    while (static_cast<double>(result) * maxLoadFactor < count)
+      ++result;
+    return result;
+  }
+
+  static size_type bucketIndex(std::size_t hash, size_type bucketsNumber)
+  {
+    return IndexPolicy::index(hash, bucketsNumber);
+  }
+
+  size_type virtualBucketCount() const
+  {
+    return oldTable.size() + table.size();
+  }
 
-  class ConstIterator;
-  class Iterator;
-  using iterator = Iterator;
-  using const_iterator = ConstIterator;
+  // Old bucket i is split into new buckets i and i + oldTable.size(), so a key
+  // whose old bucket was not migrated yet can only be found in the old table.
+  size_type bucketOf(std::size_t hash) const
+  {
+    if (isRehashing())
+    {
+      auto oldBucket = bucketIndex(hash, oldTable.size());
+      if (oldBucket >= migratedBuckets)
+        return oldBucket;
+    }
+    return oldTable.size() + bucketIndex(hash, buckets);
+  }
 
-  HashMap() : table(table_type(initialBucketsNumber)), buckets(initialBucketsNumber), size(0) {}
+  bool isLive(size_type bucket) const
+  {
+    if (bucket < oldTable.size())
+      return bucket >= migratedBuckets;
+    if (!isRehashing())
+      return true;
+    return (bucket - oldTable.size()) % oldTable.size() < migratedBuckets;
+  }
 
-  HashMap(std::initializer_list<value_type> list)
+  const BucketArray &bucketStorage(size_type bucket) const
   {
-    size_type s = list.size();
-    size = s;
+    return bucket < oldTable.size() ? oldTable : table;
+  }
 
-    s = s < initialBucketsNumber ? initialBucketsNumber : s;
-    table = table_type(s);
-    buckets = s;
+  BucketArray &bucketStorage(size_type bucket)
+  {
+    return bucket < oldTable.size() ? oldTable : table;
+  }
 
-    for (auto &item : list)
-      table[hash(item.first)].push_back(item);
+  size_type localIndex(size_type bucket) const
+  {
+    return bucket < oldTable.size() ? bucket : bucket - oldTable.size();
   }
 
-  bool isEmpty() const
+  const list_type &bucketAt(size_type bucket) const
   {
-    return size == 0;
+    return bucketStorage(bucket)[localIndex(bucket)];
   }
 
-  mapped_type &operator[](const key_type &key)
+  list_type &bucketAt(size_type bucket)
+  {
+    return bucketStorage(bucket)[localIndex(bucket)];
+  }
+
+  // Only live buckets can have their bit set, dead ones need no check.
+  size_type nextNonEmptyBucket(size_type bucket) const
+  {
+    if (bucket < oldTable.size())
+    {
+      auto next = oldTable.nextOccupied(bucket);
+      if (next < oldTable.size())
+        return next;
+      bucket = oldTable.size();
+    }
+    return oldTable.size() + table.nextOccupied(bucket - oldTable.size());
+  }
+
+  // Last non-empty bucket before bucket, virtualBucketCount() if there is none.
+  size_type previousNonEmptyBucket(size_type bucket) const
+  {
+    if (bucket > oldTable.size())
+    {
+      auto previous = table.previousOccupied(bucket - oldTable.size());
+      if (previous < table.size())
+        return oldTable.size() + previous;
+      bucket = oldTable.size();
+    }
+    auto previous = oldTable.previousOccupied(bucket);
+    return previous < oldTable.size() ? previous : virtualBucketCount();
+  }
+
+  void bucketAdded(size_type bucket)
+  {
+    bucketStorage(bucket).updateOccupied(localIndex(bucket));
+    if (size == 0 || bucket < firstBucket)
+      firstBucket = bucket;
+  }
+
+  void bucketRemoved(size_type bucket)
+  {
+    bucketStorage(bucket).updateOccupied(localIndex(bucket));
+    if (bucket == firstBucket && bucketAt(bucket).empty())
+      firstBucket = nextNonEmptyBucket(bucket);
+  }
+
+  void ensureTable()
+  {
+    if (buckets == 0) // moved-from map
+    {
+      table = BucketArray(initialBucketsNumber);
+      table.create(0, initialBucketsNumber);
+      buckets = initialBucketsNumber;
+    }
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+  {
+    ensureTable();
+    const auto h = hash(key);
+    auto bucket = bucketOf(h);
+    auto &list = bucketAt(bucket);
+    auto it = bloomRulesOut(h) ? list.end() : findKeyInList(key, h, list);
+    if (it != list.end())
+      return { iterator(const_iterator(this, bucket, it)), false };
+
+    emplaceEntry(list, h, std::is_same<mapped_type, detail::NoValue>(), std::forward<K>(key),
+                 std::forward<Args>(args)...);
+    return { entryAdded(bucket, h), true };
+  }
+
+  // Moves the node of handle to the front of its bucket; the key must not be
+  // in the map yet.
+  iterator linkNode(node_type &handle, std::size_t h)
+  {
+    handle.node.front().setHash(h);
+    const auto bucket = bucketOf(h);
+    auto &list = bucketAt(bucket);
+    list.splice(list.begin(), handle.node, handle.node.begin());
+    return entryAdded(bucket, h);
+  }
+
+  // Bookkeeping for the entry just put at the front of bucket; returns its
+  // position.
+  iterator entryAdded(size_type bucket, std::size_t h)
+  {
+    // nodes never move in memory, neither rehash nor migration invalidates this pointer
+    const entry_type *entry = &bucketAt(bucket).front();
+    entryLinked(bucket, h);
+
+    // The node may have been spliced into another bucket meanwhile; it is
+    // found there by address, without comparing keys.
+    bucket = bucketOf(h);
+    auto &current = bucketAt(bucket);
+    auto position = std::find_if(current.begin(), current.end(), [entry](const entry_type &other) {
+      return &other == entry;
+    });
+    return iterator(const_iterator(this, bucket, position));
+  }
+
+  void unlink(const const_iterator &it)
+  {
+    auto &list = bucketAt(it.bucketNumber);
+    chainErasing(list, it.bucketIterator);
+    list.erase(it.bucketIterator);
+    bucketRemoved(it.bucketNumber);
+    --size;
+    bloomRemoved();
+  }
+
+  template <typename InputIt>
+  void insertRange(InputIt first, InputIt last, std::input_iterator_tag)
+  {
+    for (; first != last; ++first)
+      tryEmplace((*first).first, (*first).second);
+  }
+
+  template <typename ForwardIt>
+  void insertRange(ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+  {
+    struct Pending
+    {
+      size_type bucket;
+      std::size_t hash;
+      ForwardIt item;
+    };
+
+    reserve(size + static_cast<size_type>(std::distance(first, last)));
+    ensureTable();
+    std::vector<Pending> pending;
+    pending.reserve(static_cast<size_type>(std::distance(first, last)));
+    for (; first != last; ++first)
+    {
+      const auto h = hash((*first).first);
+      pending.push_back({ bucketIndex(h, buckets), h, first });
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const Pending &a, const Pending &b) { return a.bucket < b.bucket; });
+
+    for (auto &item : pending)
+    {
+      const auto bucket = bucketOf(item.hash);
+      auto &list = bucketAt(bucket);
+      const auto &key = (*item.item).first;
+      if (!bloomRulesOut(item.hash) && findKeyInList(key, item.hash, list) != list.end())
+        continue;
+
+      list.emplace_front(item.hash, *item.item);
+      entryLinked(bucket, item.hash);
+    }
+  }
+
+  void entryLinked(size_type bucket, std::size_t h)
+  {
+    chainInserted(bucketAt(bucket), h);
+    bloomAdded(h);
+    bucketAdded(bucket);
+    if (++size > maximumSize())
+      grow();
+    // a migration started here takes its first step at once, as the next
+    // growth may be only a few inserts away
+    migrateStep();
+  }
+
+  node_type extractAt(const const_iterator &it)
+  {
+    auto &list = bucketAt(it.bucketNumber);
+    chainErasing(list, it.bucketIterator);
+    node_type handle;
+    handle.node.splice(handle.node.begin(), list, it.bucketIterator);
+    bucketRemoved(it.bucketNumber);
+    --size;
+    bloomRemoved();
+    migrateStep();
+    return handle;
+  }
+
+  template <typename K, typename... Args>
+  static void emplaceEntry(list_type &list, std::size_t h, std::false_type, K &&key, Args &&... args)
+  {
+    list.emplace_front(h, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  // a set (see HashSet.h) keeps the key alone
+  template <typename K>
+  static void emplaceEntry(list_type &list, std::size_t h, std::true_type, K &&key)
+  {
+    list.emplace_front(h, std::forward<K>(key));
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K &&key, M &&value)
+  {
+    auto result = tryEmplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  template <typename K>
+  const_iterator constIteratorFind(const K &key) const
+  {
+    if (size == 0)
+      return cend();
+
+    const auto h = hash(key);
+    if (bloomRulesOut(h))
+      return cend();
+    return findWithHash(key, h);
+  }
+
+  template <typename K>
+  const_iterator findWithHash(const K &key, std::size_t h) const
   {
-    auto &list = table[hash(key)];
-    auto it = std::find_if(list.begin(), list.end(), [&key](const value_type &other) { return other.first == key; });
+    auto bucket = bucketOf(h);
+    auto &list = bucketAt(bucket);
+    auto it = findKeyInList(key, h, list);
+
     if (it == list.end())
+      return cend();
+
+    return const_iterator(this, bucket, it);
+  }
+
+  template <typename KeyIterator, typename Emit>
+  void findBatched(KeyIterator first, KeyIterator last, Emit emit) const
+  {
+    std::size_t hashes[findBatchSize];
+    size_type bucketNumbers[findBatchSize];
+
+    while (first != last)
     {
-      list.emplace_back(key, ValueType{});
-      if (++size >= buckets * 10 / 9)
+      auto batchFirst = first;
+      size_type count = 0;
+      for (; first != last && count < findBatchSize; ++first, ++count)
+      {
+        if (size == 0)
+          continue;
+        hashes[count] = hash(*first);
+        bucketNumbers[count] = bucketOf(hashes[count]);
+        detail::prefetch(&bucketAt(bucketNumbers[count]));
+      }
+
+      if (size == 0)
+      {
+        for (size_type i = 0; i < count; ++i)
+          emit(cend());
+        continue;
+      }
+
+      for (size_type i = 0; i < count; ++i)
       {
-        doubleCapacity();
-        return valueOf(key);
+        auto &list = bucketAt(bucketNumbers[i]);
+        if (!list.empty())
+          detail::prefetch(&list.front());
       }
 
-      return list.back().second;
+      for (size_type i = 0; i < count; ++i, ++batchFirst)
+      {
+        auto &list = bucketAt(bucketNumbers[i]);
+        if (bloomRulesOut(hashes[i]))
+        {
+          emit(cend());
+          continue;
+        }
+        auto it = findKeyInList(*batchFirst, hashes[i], list);
+        emit(it == list.end() ? cend() : const_iterator(this, bucketNumbers[i], it));
+      }
     }
-    return it->second;
   }
 
-  const mapped_type &valueOf(const key_type &key) const
+  template <typename K>
+  const mapped_type &constValueOf(const K &key) const
   {
-    const_iterator it = find(key);
+    const_iterator it = constIteratorFind(key);
     if (it == end())
       throw std::out_of_range("Key does not exists");
 
     return it->second;
   }
 
-  mapped_type &valueOf(const key_type &key)
+  template <typename K>
+  void removeKey(const K &key)
   {
-    iterator it = find(key);
-    if (it == end())
-      throw std::out_of_range("Key does not exists");
+    if (size == 0)
+      throw std::out_of_range("Removing non existing key");
 
-    return it->second;
+    const auto h = hash(key);
+    const auto bucket = bucketOf(h);
+    auto &list = bucketAt(bucket);
+    auto it = bloomRulesOut(h) ? list.end() : findKeyInList(key, h, list);
+
+    if (it == list.end())
+      throw std::out_of_range("Removing non existing key");
+
+    chainErasing(list, it);
+    list.erase(it);
+    bucketRemoved(bucket);
+    --size;
+    bloomRemoved();
+    migrateStep();
   }
 
-  const_iterator find(const key_type &key) const
+  template <typename K, typename List>
+  auto findKeyInList(const K &key, std::size_t hash, List &list) const -> decltype(std::begin(list))
   {
-    return constIteratorFind(key);
+    if (!chainTrees.isEmpty() && chainLength(list) >= untreeifyThreshold && isTreeSearchable(key))
+      return findKeyInTree(key, hash, list);
+    return scanList(key, hash, list);
   }
 
-  iterator find(const key_type &key)
+  template <typename K, typename List>
+  auto scanList(const K &key, std::size_t hash, List &list) const -> decltype(std::begin(list))
   {
-    return iterator(constIteratorFind(key));
+    return std::find_if(std::begin(list), std::end(list), [&](const entry_type &other) {
+      return other.hashEquals(hash) && keyEqual(detail::StoredValue<key_type, mapped_type>::keyOf(other.value), key);
+    });
   }
 
-  void remove(const key_type &key)
+  template <typename K, typename List>
+  auto findKeyInTree(const K &key, std::size_t hash, List &list) const -> decltype(std::begin(list))
   {
-    auto &list = table[hash(key)];
-    auto it = findKeyInList(key, list);
+    auto tree = chainTrees.find(&list);
+    if (tree == chainTrees.end())
+      return scanList(key, hash, list);
 
-    if (it == list.end())
-      throw std::out_of_range("Removing non existing key");
+    auto group = tree->second.find(ChainKey(hash, chainKeyOf(key)));
+    if (group == tree->second.end())
+      return std::end(list);
 
-    list.erase(it);
-    --size;
+    for (auto &it : group->second)
+    {
+      if (keyEqual(detail::StoredValue<key_type, mapped_type>::keyOf(it->value), key))
+        return it;
+    }
+    return std::end(list);
   }
 
-  void remove(const const_iterator &it)
+  // A heterogeneous key cannot be compared with the stored ones by operator<.
+  static bool isTreeSearchable(const key_type &)
   {
-    if (it == end())
-      throw std::out_of_range("Removing end iterator");
+    return true;
+  }
 
-    auto &list = table[it.bucketNumber];
-    list.erase(it.bucketIterator);
-    --size;
+  template <typename K>
+  static bool isTreeSearchable(const K &)
+  {
+    return !OrderedKeys::value;
   }
 
-  size_type getSize() const
+  static const key_type *chainKeyOf(const key_type &key)
   {
-    return size;
+    return &key;
   }
 
-  bool operator==(const HashMap &other) const
+  template <typename K>
+  static const key_type *chainKeyOf(const K &)
   {
-    for (auto &item : other)
-    {
-      auto it = find(item.first);
-      if (it == end() || it->second != item.second)
-        return false;
-    }
-    return size == other.size;
+    return nullptr;
   }
 
-  bool operator!=(const HashMap &other) const
+  static ChainKey chainKeyOf(const entry_type &entry, std::size_t hash)
   {
-    return !(*this == other);
+    return ChainKey(hash, &detail::StoredValue<key_type, mapped_type>::keyOf(entry.value));
   }
 
-  iterator begin()
+  static size_type chainLength(const list_type &list)
   {
-    return iterator(cbegin());
+    return chainLength(list, detail::HasSize<list_type>());
   }
 
-  iterator end()
+  static size_type chainLength(const list_type &list, std::true_type)
   {
-    return iterator(cend());
+    return list.size();
   }
 
-  const_iterator cbegin() const
+  // ForwardChain does not count its nodes, so it is never treeified.
+  static size_type chainLength(const list_type &, std::false_type)
   {
-    if (size == 0)
-      return cend();
+    return 0;
+  }
 
-    auto &firstBucket = table[0];
-    auto it = firstBucket.begin();
-    if (firstBucket.size() != 0)
-      return const_iterator(table, 0, it);
-    return ++const_iterator(table, 0, it);
+  // Has to be called after the entry of the given hash was put at the front of list.
+  void chainInserted(list_type &list, std::size_t hash)
+  {
+    // a chain that shrank between the thresholds still has its tree, which
+    // has to see the entry as well; shorter chains never have one
+    if (chainLength(list) <= untreeifyThreshold)
+      return;
+
+    auto tree = chainTrees.find(&list);
+    if (tree != chainTrees.end())
+      tree->second[chainKeyOf(list.front(), hash)].push_back(list.begin());
+    else if (chainLength(list) >= treeifyThreshold)
+      treeify(list);
   }
 
-  const_iterator cend() const
+  // Has to be called before the entry at position is erased from list.
+  template <typename ListIterator>
+  void chainErasing(list_type &list, ListIterator position)
   {
-    return const_iterator(table, buckets - 1, table[buckets - 1].end());
+    if (chainLength(list) < untreeifyThreshold || chainTrees.isEmpty())
+      return;
+
+    auto tree = chainTrees.find(&list);
+    if (tree == chainTrees.end())
+      return;
+    if (chainLength(list) == untreeifyThreshold)
+    {
+      chainTrees.remove(tree);
+      return;
+    }
+
+    auto group = tree->second.find(chainKeyOf(*position, position->hash(hashFunction)));
+    auto &entries = group->second;
+    entries.erase(std::find(entries.begin(), entries.end(), position));
+    if (entries.empty())
+      tree->second.remove(group);
   }
 
-  const_iterator begin() const
+  void treeify(list_type &list)
   {
-    return cbegin();
+    ChainTree tree;
+    for (auto it = list.begin(); it != list.end(); ++it)
+      tree[chainKeyOf(*it, it->hash(hashFunction))].push_back(it);
+    chainTrees[&list] = std::move(tree);
   }
 
-  const_iterator end() const
+  void treeifyIfLong(list_type &list)
   {
-    return cend();
+    if (chainLength(list) >= treeifyThreshold && chainTrees.find(&list) == chainTrees.end())
+      treeify(list);
   }
 
-private:
+  void untreeify(const list_type &list)
+  {
+    if (chainTrees.isEmpty())
+      return;
 
-  table_type table;
-  size_type buckets;
-  size_type size;
+    auto tree = chainTrees.find(&list);
+    if (tree != chainTrees.end())
+      chainTrees.remove(tree);
+  }
 
-  static const size_type initialBucketsNumber = 8;
+  // After the nodes were copied or redistributed wholesale.
+  void treeifyLongChains()
+  {
+    if (!detail::HasSize<list_type>::value || size < treeifyThreshold)
+      return;
+
+    for (size_type i = 0; i < virtualBucketCount(); ++i)
+    {
+      if (isLive(i))
+        treeifyIfLong(bucketAt(i));
+    }
+  }
 
-  size_type hash(const key_type &key) const
+  bool bloomRulesOut(std::size_t h) const
   {
-    return (std::hash<key_type>{}(key)) % buckets;
+    return bloomFilterEnabled && !bloomFilter.mayContain(h);
   }
 
-  const_iterator constIteratorFind(const key_type &key) const
+  void bloomAdded(std::size_t h)
   {
-    auto bucket = hash(key);
-    auto &list = table[bucket];
-    auto it = findKeyInList(key, list);
+    if (!bloomFilterEnabled)
+      return;
+    bloomFilter.add(h);
+    if (isRehashing())
+      nextBloomFilter.add(h);
+  }
 
-    if (it == list.end())
-      return cend();
+  // Removed keys stay in the filter and only add false positives. Once they
+  // outnumber half of the live keys, or of the buckets in a mostly empty
+  // table, the filter is built anew: O(size + buckets) for at least as many
+  // removals halved, so constant time per removal on average.
+  void bloomRemoved(size_type count = 1)
+  {
+    if (!bloomFilterEnabled)
+      return;
+    removedSinceBloomBuild += count;
+    if (removedSinceBloomBuild > std::max(size, buckets) / 2)
+      rebuildBloomFilter();
+  }
 
-    return const_iterator(table, bucket, it);
+  // Sized for the most keys bucketsNumber buckets hold before growing;
+  // unsized, and so free, while the filter is off.
+  detail::BlockedBloomFilter sizedBloomFilter(size_type bucketsNumber) const
+  {
+    if (!bloomFilterEnabled)
+      return detail::BlockedBloomFilter();
+    return detail::BlockedBloomFilter(static_cast<size_type>(bucketsNumber * maxLoadFactor) + 1);
   }
 
-  static typename  list_type::const_iterator findKeyInList(const key_type &key, const list_type &list)
+  void rebuildBloomFilter()
   {
-    auto it = std::find_if(std::begin(list), std::end(list),
-                        [&key](const value_type &other) { return other.first == key; }); 
-    return it; 
+    auto filter = sizedBloomFilter(buckets);
+    for (size_type i = 0; i < virtualBucketCount(); ++i)
+    {
+      if (!isLive(i))
+        continue;
+      for (auto &entry : bucketAt(i))
+        filter.add(entry.hash(hashFunction));
+    }
+    // while migrating, the new table will hold the same keys
+    nextBloomFilter = isRehashing() ? filter : detail::BlockedBloomFilter();
+    bloomFilter = std::move(filter);
+    removedSinceBloomBuild = 0;
   }
 
-  // static typename  list_type::iterator findKeyInList(const key_type &key, list_type &list)
-  // {
-  //   auto it = findKeyInList(key, list);
-  //   return list.erase(it, it); 
-  // }
+  void grow()
+  {
+    if (rehashMode == RehashMode::Immediate)
+      doubleCapacity();
+    else
+      startMigration();
+  }
 
   void doubleCapacity()
   {
-    buckets *= 2;
-    auto newTable = table_type(buckets);
-    for (auto &&bucket : table)
+    rehashTo(buckets * 2);
+  }
+
+  // Moves every node into a freshly built table of newBuckets buckets.
+  void rehashTo(size_type newBuckets)
+  {
+    migrateBuckets(oldTable.size());
+    chainTrees = ChainTrees();
+
+    auto newTable = BucketArray(newBuckets);
+    newTable.create(0, newBuckets);
+    auto newFilter = sizedBloomFilter(newBuckets);
+    for (size_type i = 0; i < table.size(); ++i)
     {
+      auto &bucket = table[i];
       auto it = bucket.begin();
       while (it != bucket.end())
       {
-        auto &newBucket = newTable[hash(it->first)];
-        newBucket.splice(newBucket.begin(), bucket, it);
+        const auto h = it->hash(hashFunction);
+        const auto index = bucketIndex(h, newBuckets);
+        newTable[index].splice(newTable[index].begin(), bucket, it);
+        newTable.updateOccupied(index);
+        newFilter.add(h);
         it = bucket.begin();
       }
     }
+    table.destroy(0, table.size());
     table = std::move(newTable);
+    buckets = newBuckets;
+    bloomFilter = std::move(newFilter);
+    removedSinceBloomBuild = 0;
+    firstBucket = nextNonEmptyBucket(0);
+    treeifyLongChains();
+  }
+
+  // Allocates the doubled table without touching it; its lists are created
+  // pairwise as old buckets get migrated.
+  void startMigration()
+  {
+    migrateBuckets(oldTable.size());
+
+    oldTable = std::move(table);
+    buckets *= 2;
+    table = BucketArray(buckets);
+    migratedBuckets = 0;
+    nextBloomFilter = sizedBloomFilter(buckets);
+  }
+
+  // Moves at least migrationStep buckets, more if needed to keep pace with
+  // the inserts left before the next growth: with a low max_load_factor
+  // there are fewer of them than old buckets, and a migration still running
+  // at that growth would have to be finished in one go.
+  void migrateStep()
+  {
+    if (!isRehashing())
+      return;
+
+    const auto headroom = std::max(maximumSize() - static_cast<double>(size), 1.0);
+    const auto pace = static_cast<size_type>(std::ceil((oldTable.size() - migratedBuckets) / headroom));
+    migrateBuckets(std::max(size_type(migrationStep), pace));
+  }
+
+  void migrateBuckets(size_type count)
+  {
+    for (; count > 0 && isRehashing(); --count)
+    {
+      const auto oldSize = oldTable.size();
+      const auto i = migratedBuckets;
+
+      table.create(i, i + 1);
+      table.create(i + oldSize, i + oldSize + 1);
+
+      auto &bucket = oldTable[i];
+      untreeify(bucket);
+      auto it = bucket.begin();
+      while (it != bucket.end())
+      {
+        const auto h = it->hash(hashFunction);
+        const auto index = bucketIndex(h, buckets);
+        table[index].splice(table[index].begin(), bucket, it);
+        table.updateOccupied(index);
+        nextBloomFilter.add(h);
+        it = bucket.begin();
+      }
+      oldTable.destroy(i, i + 1);
+      // the only buckets an old one is split into
+      treeifyIfLong(table[i]);
+      treeifyIfLong(table[i + oldSize]);
+      // its nodes moved to the new table, behind every old bucket
+      if (firstBucket == i)
+        firstBucket = nextNonEmptyBucket(i);
+
+      if (++migratedBuckets == oldSize)
+      {
+        oldTable = BucketArray();
+        migratedBuckets = 0;
+        if (bloomFilterEnabled)
+          bloomFilter = std::move(nextBloomFilter);
+        nextBloomFilter = detail::BlockedBloomFilter();
+        firstBucket = firstBucket < oldSize ? 0 : firstBucket - oldSize;
+      }
+    }
+  }
+
+  void destroyBuckets()
+  {
+    for (size_type i = 0; i < virtualBucketCount(); ++i)
+    {
+      if (isLive(i))
+        bucketStorage(i).destroy(localIndex(i), localIndex(i) + 1);
+    }
+    chainTrees = ChainTrees();
+    // unsized filters let every key through until the next rebuild
+    bloomFilter = nextBloomFilter = detail::BlockedBloomFilter();
+    table = BucketArray();
+    oldTable = BucketArray();
+    buckets = size = migratedBuckets = firstBucket = 0;
+  }
+
+  void swap(HashMap &other) noexcept
+  {
+    std::swap(table, other.table);
+    std::swap(oldTable, other.oldTable);
+    std::swap(buckets, other.buckets);
+    std::swap(size, other.size);
+    std::swap(migratedBuckets, other.migratedBuckets);
+    std::swap(firstBucket, other.firstBucket);
+    std::swap(chainTrees, other.chainTrees);
+    bloomFilter.swap(other.bloomFilter);
+    nextBloomFilter.swap(other.nextBloomFilter);
+    std::swap(bloomFilterEnabled, other.bloomFilterEnabled);
+    std::swap(removedSinceBloomBuild, other.removedSinceBloomBuild);
+    std::swap(rehashMode, other.rehashMode);
+    std::swap(maxLoadFactor, other.maxLoadFactor);
+    std::swap(hashFunction, other.hashFunction);
+    std::swap(keyEqual, other.keyEqual);
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename IndexPolicy, bool StoreHash,
+          typename Allocator, template <typename, typename> class Chain>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, IndexPolicy, StoreHash, Allocator, Chain>::ConstIterator
 {
 public:
   using reference = typename HashMap::const_reference;
   using iterator_category = std::bidirectional_iterator_tag;
   using value_type = typename HashMap::value_type;
+  using difference_type = std::ptrdiff_t;
   using pointer = const typename HashMap::value_type *;
   using size_type = HashMap::size_type;
   using list_type = typename HashMap::list_type;
   using list_iterator = typename list_type::const_iterator;
-  using table_type = const HashMap::table_type;
 
-  explicit ConstIterator(table_type &buckets, size_type bucketNumber,
-                         list_iterator it) : buckets(buckets), bucketNumber(bucketNumber), bucketIterator(it)
+  ConstIterator() : map(nullptr), bucketNumber(0), bucketIterator()
+  {
+  }
+
+  explicit ConstIterator(const HashMap *map, size_type bucketNumber,
+                         list_iterator it) : map(map), bucketNumber(bucketNumber), bucketIterator(it)
   {
   }
 
-  ConstIterator(const ConstIterator &other) : buckets(other.buckets), bucketNumber(other.bucketNumber), bucketIterator(other.bucketIterator)
+  ConstIterator(const ConstIterator &other) : map(other.map), bucketNumber(other.bucketNumber), bucketIterator(other.bucketIterator)
   {
   }
 
@@ -262,27 +1653,13 @@ public:
 
   ConstIterator operator++(int)
   {
-    auto &bucket = buckets[bucketNumber];
-
-    if (bucketNumber + 1 >= buckets.size() && bucketIterator == bucket.end())
+    if (bucketNumber >= map->virtualBucketCount())
       throw std::out_of_range("Incrementing end iterator");
 
-    if (++bucketIterator == bucket.end())
+    if (++bucketIterator == map->bucketAt(bucketNumber).end())
     {
-      while (true)
-      {
-        auto &bucket = buckets[++bucketNumber];
-        if (bucket.size() != 0)
-        {
-          bucketIterator = bucket.begin();
-          break;
-        }
-        if (bucketNumber >= buckets.size() - 1)
-        {
-          bucketIterator = bucket.end();
-          break;
-        }
-      }
+      bucketNumber = map->nextNonEmptyBucket(bucketNumber + 1);
+      bucketIterator = bucketNumber < map->virtualBucketCount() ? map->bucketAt(bucketNumber).begin() : list_iterator();
     }
     return *this;
   }
@@ -295,30 +1672,26 @@ public:
 
   ConstIterator operator--(int)
   {
-    auto &bucket = buckets[bucketNumber];
-    if (bucketIterator == bucket.begin())
+    if (bucketNumber < map->virtualBucketCount() && bucketIterator != map->bucketAt(bucketNumber).begin())
     {
-      while (true)
-      {
-        if (bucketNumber == 0)
-          throw std::out_of_range("Decrementing begin iterator");
-
-        auto &bucket = buckets[--bucketNumber];
-        if (bucket.size() != 0)
-        {
-          bucketIterator = --(bucket.end());
-          break;
-        }
-      }
+      --bucketIterator;
+      return *this;
     }
+
+    auto bucket = map->previousNonEmptyBucket(bucketNumber);
+    if (bucket >= map->virtualBucketCount())
+      throw std::out_of_range("Decrementing begin iterator");
+
+    bucketNumber = bucket;
+    bucketIterator = --(map->bucketAt(bucket).end());
     return *this;
   }
 
   reference operator*() const
   {
-    if (bucketIterator == buckets[buckets.size() - 1].end())
+    if (bucketNumber >= map->virtualBucketCount())
       throw std::out_of_range("Dereferencing end iterator");
-    return *bucketIterator;
+    return bucketIterator->value;
   }
 
   pointer operator->() const
@@ -328,7 +1701,12 @@ public:
 
   bool operator==(const ConstIterator &other) const
   {
-    return bucketNumber == other.bucketNumber && bucketIterator == other.bucketIterator;
+    // default-constructed iterators belong to no map and are all equal
+    if (map == nullptr || other.map == nullptr)
+      return map == other.map;
+    if (bucketNumber != other.bucketNumber)
+      return false;
+    return bucketNumber >= map->virtualBucketCount() || bucketIterator == other.bucketIterator;
   }
 
   bool operator!=(const ConstIterator &other) const
@@ -336,13 +1714,15 @@ public:
     return !(*this == other);
   }
 
-  table_type &buckets;
+  const HashMap *map;
   size_type bucketNumber;
   list_iterator bucketIterator;
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename IndexPolicy, bool StoreHash,
+          typename Allocator, template <typename, typename> class Chain>
+class HashMap<KeyType, ValueType, Hash, KeyEqual, IndexPolicy, StoreHash, Allocator, Chain>::Iterator
+    : public HashMap<KeyType, ValueType, Hash, KeyEqual, IndexPolicy, StoreHash, Allocator, Chain>::ConstIterator
 {
 public:
   using reference = typename HashMap::reference;
@@ -395,6 +1775,13 @@ public:
   }
 };
 
+// HashMap tuned for memory: pooled nodes on singly linked chains.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+using CompactHashMap = HashMap<KeyType, ValueType, Hash, KeyEqual, PowerOfTwoIndexing, false,
+                               PoolAllocator<std::pair<KeyType, ValueType>>, ForwardChain>;
+
 } // namespace aisdi
 
 #endif /* AISDI_MAPS_HASHMAP_H */
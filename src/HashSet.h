@@ -0,0 +1,212 @@
+#ifndef AISDI_MAPS_HASHSET_H
+#define AISDI_MAPS_HASHSET_H
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "HashMap.h"
+
+namespace aisdi
+{
+
+// Set of keys on the HashMap engine. The nodes hold the key alone, without
+// the mapped value and its padding that HashMap<K, bool> would carry.
+// Template parameters mean the same as for HashMap.
+template <typename KeyType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>,
+          typename IndexPolicy = PowerOfTwoIndexing,
+          bool StoreHash = false,
+          typename Allocator = std::allocator<KeyType>,
+          template <typename, typename> class Chain = std::list>
+class HashSet
+{
+public:
+  using map_type = HashMap<KeyType, detail::NoValue, Hash, KeyEqual, IndexPolicy, StoreHash, Allocator, Chain>;
+  using key_type = KeyType;
+  using value_type = KeyType;
+  using size_type = std::size_t;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  // keys cannot be changed in place, both iterators are constant
+  using const_iterator = typename map_type::const_iterator;
+  using iterator = const_iterator;
+
+  HashSet() = default;
+
+  HashSet(std::initializer_list<value_type> list)
+  {
+    insert(list.begin(), list.end());
+  }
+
+  template <typename InputIt>
+  HashSet(InputIt first, InputIt last)
+  {
+    insert(first, last);
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+  size_type getSize() const
+  {
+    return map.getSize();
+  }
+
+  // Returns the key's position and whether it was inserted.
+  std::pair<const_iterator, bool> insert(const key_type &key)
+  {
+    auto result = map.try_emplace(key);
+    return { result.first, result.second };
+  }
+
+  std::pair<const_iterator, bool> insert(key_type &&key)
+  {
+    auto result = map.try_emplace(std::move(key));
+    return { result.first, result.second };
+  }
+
+  // A range of forward iterators is counted first, so the table grows at
+  // most once.
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    reserveFor(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    for (; first != last; ++first)
+      map.try_emplace(*first);
+  }
+
+  bool contains(const key_type &key) const
+  {
+    return map.find(key) != map.end();
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    return map.find(key);
+  }
+
+  void remove(const key_type &key)
+  {
+    map.remove(key);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    map.remove(it);
+  }
+
+  void reserve(size_type count)
+  {
+    map.reserve(count);
+  }
+
+  bool operator==(const HashSet &other) const
+  {
+    if (getSize() != other.getSize())
+      return false;
+
+    for (auto &key : other)
+    {
+      if (!contains(key))
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const HashSet &other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator begin() const
+  {
+    return map.cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return map.cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return map.cbegin();
+  }
+
+  const_iterator cend() const
+  {
+    return map.cend();
+  }
+
+  // Set operations. Each fills its result directly, in time linear in the
+  // sizes of the arguments; both have to use equal hash functions.
+
+  friend HashSet unionOf(const HashSet &first, const HashSet &second)
+  {
+    const auto &larger = first.getSize() >= second.getSize() ? first : second;
+    const auto &smaller = first.getSize() >= second.getSize() ? second : first;
+
+    HashSet result(larger);
+    result.reserve(larger.getSize() + smaller.getSize());
+    for (auto &key : smaller)
+      result.map.try_emplace(key);
+    return result;
+  }
+
+  friend HashSet intersectionOf(const HashSet &first, const HashSet &second)
+  {
+    const auto &larger = first.getSize() >= second.getSize() ? first : second;
+    const auto &smaller = first.getSize() >= second.getSize() ? second : first;
+
+    HashSet result;
+    result.reserve(smaller.getSize());
+    for (auto &key : smaller)
+    {
+      if (larger.contains(key))
+        result.map.try_emplace(key);
+    }
+    return result;
+  }
+
+  // Keys of first that are not in second.
+  friend HashSet differenceOf(const HashSet &first, const HashSet &second)
+  {
+    HashSet result;
+    result.reserve(first.getSize());
+    for (auto &key : first)
+    {
+      if (!second.contains(key))
+        result.map.try_emplace(key);
+    }
+    return result;
+  }
+
+private:
+  map_type map;
+
+  template <typename InputIt>
+  void reserveFor(InputIt first, InputIt last, std::forward_iterator_tag)
+  {
+    reserve(getSize() + static_cast<size_type>(std::distance(first, last)));
+  }
+
+  template <typename InputIt>
+  void reserveFor(InputIt, InputIt, std::input_iterator_tag)
+  {
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_HASHSET_H */
@@ -0,0 +1,156 @@
+#ifndef AISDI_MAPS_HASHUTILS_H
+#define AISDI_MAPS_HASHUTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace aisdi
+{
+namespace detail
+{
+
+// 64-bit finalizer from MurmurHash3. std::hash<int> is the identity, so
+// every engine that slices a hash into bucket index / fingerprint mixes it first.
+inline std::uint64_t mixHash(std::uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline std::size_t roundUpToPowerOfTwo(std::size_t n)
+{
+  std::size_t result = 1;
+  while (result < n)
+    result <<= 1;
+  return result;
+}
+
+inline unsigned countTrailingZeros(std::uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+  unsigned result = 0;
+  while ((mask & 1u) == 0)
+  {
+    mask >>= 1;
+    ++result;
+  }
+  return result;
+#endif
+}
+
+inline unsigned countTrailingZeros(std::uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+  unsigned result = 0;
+  while ((mask & 1u) == 0)
+  {
+    mask >>= 1;
+    ++result;
+  }
+  return result;
+#endif
+}
+
+// Index of the highest set bit; mask must not be zero.
+inline unsigned highestBitIndex(std::uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(mask));
+#else
+  unsigned result = 0;
+  while (mask >>= 1)
+    ++result;
+  return result;
+#endif
+}
+
+// Hint to pull the cache line holding address in for reading.
+inline void prefetch(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+// 64-bit FNV-1a
+inline std::uint64_t hashBytes(const char *data, std::size_t length)
+{
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < length; ++i)
+  {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+} // namespace detail
+
+// Transparent hash for string keys. std::string and C strings hash to the same
+// value, so a HashMap<std::string, V, StringHash, std::equal_to<>> can be
+// searched with a literal without building a temporary std::string.
+struct StringHash
+{
+  using is_transparent = void;
+
+  std::size_t operator()(const std::string &key) const
+  {
+    return static_cast<std::size_t>(detail::hashBytes(key.data(), key.size()));
+  }
+
+  std::size_t operator()(const char *key) const
+  {
+    return static_cast<std::size_t>(detail::hashBytes(key, std::strlen(key)));
+  }
+};
+
+// Bucket indexing policies for HashMap. bucketCount rounds a requested number
+// of buckets to one the policy can address, index maps a std::hash value to
+// a bucket. Both policies keep the property that doubling the bucket count
+// splits bucket i into buckets i and i + oldCount.
+
+// Keeps the bucket count a power of two and picks the bucket with a mask over
+// the mixed hash, which is both cheaper than a division and spreads sequential
+// keys evenly.
+struct PowerOfTwoIndexing
+{
+  static std::size_t bucketCount(std::size_t requested)
+  {
+    return detail::roundUpToPowerOfTwo(requested);
+  }
+
+  static std::size_t index(std::size_t hash, std::size_t buckets)
+  {
+    return static_cast<std::size_t>(detail::mixHash(hash)) & (buckets - 1);
+  }
+};
+
+// Plain modulo of the unmixed hash, works with any bucket count.
+struct ModuloIndexing
+{
+  static std::size_t bucketCount(std::size_t requested)
+  {
+    return requested;
+  }
+
+  static std::size_t index(std::size_t hash, std::size_t buckets)
+  {
+    return hash % buckets;
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_HASHUTILS_H */
@@ -0,0 +1,405 @@
+#ifndef AISDI_MAPS_LOCKFREEHASHMAP_H
+#define AISDI_MAPS_LOCKFREEHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include "EpochReclaimer.h"
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Lock-free hash map after Shalev and Shavit, "Split-Ordered Lists".
+// All items sit in one lock-free sorted linked list (Harris / Michael style,
+// removal marks a node before unlinking it). The list is ordered by the
+// bit-reversed hash, so the items of bucket b in a table of 2^k buckets form
+// a contiguous run, and doubling the table splits every run in two in place.
+// Buckets are shortcuts into the list: bucket b points to a dummy node placed
+// right before its run, created on first use from its parent bucket.
+// The bucket table grows by doubling as well. It is a directory of segments,
+// segment s holding buckets [2^s, 2^(s+1)), so growing never moves a bucket.
+//
+// No operation ever waits for another thread: a thread stalled anywhere
+// leaves the list in a state others can work with. Unlinked nodes are freed
+// through epoch-based reclamation, see EpochReclaimer.h.
+//
+// Values are immutable once inserted, replace one with remove + insert.
+// Lookups copy the value out; there are no iterators.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class LockFreeHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  explicit LockFreeHashMap(const Hash &hashFunction = Hash(), const KeyEqual &keyEqual = KeyEqual())
+      : hashFunction(hashFunction), keyEqual(keyEqual)
+  {
+    for (auto &segment : segments)
+      segment.store(nullptr);
+    auto head = new Node(0);
+    segmentOf(0)[0].store(head);
+  }
+
+  LockFreeHashMap(const LockFreeHashMap &) = delete;
+  LockFreeHashMap &operator=(const LockFreeHashMap &) = delete;
+
+  // No other thread may use the map any more.
+  ~LockFreeHashMap()
+  {
+    auto node = bucketHead(0);
+    while (node != nullptr)
+    {
+      auto next = pointerOf(node->next.load());
+      destroy(node);
+      node = next;
+    }
+    for (auto &segment : segments)
+      delete[] segment.load();
+  }
+
+  // Returns false, leaving the map untouched, if the key is already present.
+  bool insert(const key_type &key, const mapped_type &value)
+  {
+    Guard guard;
+    const auto h = hashOf(key);
+    auto head = bucket(h & (bucketsNumber.load() - 1));
+    auto node = new DataNode(regularKey(h), key, value);
+
+    Position position;
+    while (true)
+    {
+      if (search(head, node->orderKey, &key, position))
+      {
+        delete node;
+        return false;
+      }
+
+      node->next.store(position.current);
+      auto expected = position.current;
+      if (position.link->compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node)))
+        break;
+    }
+
+    const auto buckets = bucketsNumber.load();
+    if (static_cast<size_type>(++size) > buckets * maxLoad && buckets < maxBuckets)
+    {
+      auto expected = buckets;
+      bucketsNumber.compare_exchange_strong(expected, buckets * 2);
+    }
+    return true;
+  }
+
+  // Returns false if there was no such key.
+  bool remove(const key_type &key)
+  {
+    Guard guard;
+    const auto h = hashOf(key);
+    auto head = bucket(h & (bucketsNumber.load() - 1));
+    const auto orderKey = regularKey(h);
+
+    Position position;
+    while (true)
+    {
+      if (!search(head, orderKey, &key, position))
+        return false;
+
+      auto node = pointerOf(position.current);
+      auto next = node->next.load();
+      if (isMarked(next))
+        continue;
+      // the mark makes the removal final and stops inserts after the node
+      if (!node->next.compare_exchange_strong(next, next | markBit))
+        continue;
+
+      --size;
+      auto expected = position.current;
+      if (position.link->compare_exchange_strong(expected, next))
+        retire(node);
+      else
+        search(head, orderKey, &key, position); // unlinks the node on the way
+      return true;
+    }
+  }
+
+  // Copies the value of key to value. Returns false if there is no such key.
+  bool find(const key_type &key, mapped_type &value) const
+  {
+    Guard guard;
+    const auto h = hashOf(key);
+    auto head = bucket(h & (bucketsNumber.load() - 1));
+
+    Position position;
+    if (!search(head, regularKey(h), &key, position))
+      return false;
+
+    value = static_cast<DataNode *>(pointerOf(position.current))->value.second;
+    return true;
+  }
+
+  mapped_type valueOf(const key_type &key) const
+  {
+    mapped_type value;
+    if (!find(key, value))
+      throw std::out_of_range("Key does not exists");
+    return value;
+  }
+
+  bool contains(const key_type &key) const
+  {
+    Guard guard;
+    const auto h = hashOf(key);
+    Position position;
+    return search(bucket(h & (bucketsNumber.load() - 1)), regularKey(h), &key, position);
+  }
+
+  // Exact when no thread modifies the map, approximate otherwise.
+  size_type getSize() const
+  {
+    auto result = size.load();
+    return result < 0 ? 0 : static_cast<size_type>(result);
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type bucketCount() const
+  {
+    return bucketsNumber.load();
+  }
+
+private:
+  using Guard = detail::EpochReclaimer::Guard;
+
+  // Order keys: a bucket's dummy gets the reversed bucket number, an item the
+  // reversed hash with the top bit set. Item keys are odd and dummy keys even,
+  // so a dummy sorts before every item of its bucket.
+  struct Node
+  {
+    explicit Node(std::uint64_t orderKey) : orderKey(orderKey), next(0)
+    {
+    }
+
+    bool isDummy() const
+    {
+      return (orderKey & 1) == 0;
+    }
+
+    const std::uint64_t orderKey;
+    // pointer to the next node, the lowest bit marks this node as removed
+    std::atomic<std::uintptr_t> next;
+  };
+
+  struct DataNode : Node
+  {
+    DataNode(std::uint64_t orderKey, const key_type &key, const mapped_type &value)
+        : Node(orderKey), value(key, value)
+    {
+    }
+
+    const value_type value;
+  };
+
+  // Where a searched key is or would be inserted: link holds current.
+  struct Position
+  {
+    std::atomic<std::uintptr_t> *link;
+    std::uintptr_t current;
+  };
+
+  static const std::uintptr_t markBit = 1;
+  static const std::size_t segmentsNumber = 48;
+  static const size_type maxBuckets = size_type(1) << (segmentsNumber - 1);
+  static const size_type maxLoad = 2;
+
+  // lookups initialize buckets too, hence mutable
+  mutable std::atomic<std::atomic<Node *> *> segments[segmentsNumber];
+  std::atomic<size_type> bucketsNumber{ 2 };
+  std::atomic<std::ptrdiff_t> size{ 0 };
+  Hash hashFunction;
+  KeyEqual keyEqual;
+
+  static bool isMarked(std::uintptr_t link)
+  {
+    return (link & markBit) != 0;
+  }
+
+  static Node *pointerOf(std::uintptr_t link)
+  {
+    return reinterpret_cast<Node *>(link & ~markBit);
+  }
+
+  static std::uint64_t reverseBits(std::uint64_t x)
+  {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    return (x >> 32) | (x << 32);
+  }
+
+  static std::uint64_t regularKey(std::uint64_t hash)
+  {
+    return reverseBits(hash | (std::uint64_t(1) << 63));
+  }
+
+  static std::uint64_t dummyKey(size_type bucket)
+  {
+    return reverseBits(bucket);
+  }
+
+  // The top bit of the hash is taken by the order key.
+  std::uint64_t hashOf(const key_type &key) const
+  {
+    return detail::mixHash(hashFunction(key)) & ~(std::uint64_t(1) << 63);
+  }
+
+  static void destroy(Node *node)
+  {
+    if (node->isDummy())
+      delete node;
+    else
+      delete static_cast<DataNode *>(node);
+  }
+
+  static void deleteNode(void *node)
+  {
+    destroy(static_cast<Node *>(node));
+  }
+
+  static void retire(Node *node)
+  {
+    detail::EpochReclaimer::instance().retire(node, &deleteNode);
+  }
+
+  // Buckets 0 and 1 share segment 0, then segment s holds [2^s, 2^(s+1)).
+  static std::size_t segmentIndex(size_type bucket)
+  {
+    std::size_t index = 0;
+    while ((bucket >> (index + 1)) != 0)
+      ++index;
+    return index;
+  }
+
+  std::atomic<Node *> *segmentOf(size_type bucket) const
+  {
+    const auto index = segmentIndex(bucket);
+    auto segment = segments[index].load();
+    if (segment != nullptr)
+      return segment;
+
+    const size_type length = index == 0 ? 2 : size_type(1) << index;
+    auto fresh = new std::atomic<Node *>[length];
+    for (size_type i = 0; i < length; ++i)
+      fresh[i].store(nullptr);
+    if (segments[index].compare_exchange_strong(segment, fresh))
+      return fresh;
+
+    delete[] fresh;
+    return segment;
+  }
+
+  std::atomic<Node *> &slotOf(size_type bucket) const
+  {
+    const auto index = segmentIndex(bucket);
+    const size_type first = index == 0 ? 0 : size_type(1) << index;
+    return segmentOf(bucket)[bucket - first];
+  }
+
+  Node *bucketHead(size_type bucket) const
+  {
+    return slotOf(bucket).load();
+  }
+
+  Node *bucket(size_type bucket) const
+  {
+    auto head = bucketHead(bucket);
+    return head != nullptr ? head : initializeBucket(bucket);
+  }
+
+  // The parent of a bucket is the bucket it was split from: the same number
+  // without its highest bit. The dummy goes into the parent's run, where the
+  // split order puts it at the start of this bucket's part.
+  Node *initializeBucket(size_type bucket) const
+  {
+    size_type highestBit = 1;
+    while ((bucket >> 1) >= highestBit)
+      highestBit <<= 1;
+    auto parent = this->bucket(bucket & ~highestBit);
+
+    auto dummy = new Node(dummyKey(bucket));
+    Position position;
+    while (true)
+    {
+      if (search(parent, dummy->orderKey, nullptr, position))
+      {
+        delete dummy;
+        dummy = pointerOf(position.current);
+        break;
+      }
+
+      dummy->next.store(position.current);
+      auto expected = position.current;
+      if (position.link->compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(dummy)))
+        break;
+    }
+
+    slotOf(bucket).store(dummy);
+    return dummy;
+  }
+
+  // Walks from head to the first node ordered after (orderKey, key), unlinking
+  // marked nodes it passes. Returns true if a node with the same order key
+  // (and the same key, for items) was met; position then refers to it.
+  // Otherwise position is where such a node would be linked in.
+  bool search(Node *head, std::uint64_t orderKey, const key_type *key, Position &position) const
+  {
+  retry:
+    position.link = &head->next;
+    position.current = position.link->load();
+    while (true)
+    {
+      auto node = pointerOf(position.current);
+      if (node == nullptr)
+        return false;
+
+      auto next = node->next.load();
+      if (isMarked(next))
+      {
+        auto expected = position.current;
+        if (!position.link->compare_exchange_strong(expected, next & ~markBit))
+          goto retry;
+        retire(node);
+        position.current = next & ~markBit;
+        continue;
+      }
+
+      if (node->orderKey > orderKey)
+        return false;
+      if (node->orderKey == orderKey &&
+          (key == nullptr || keyEqual(static_cast<DataNode *>(node)->value.first, *key)))
+        return true;
+
+      position.link = &node->next;
+      position.current = next;
+    }
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_LOCKFREEHASHMAP_H */
@@ -0,0 +1,108 @@
+#ifndef AISDI_MAPS_MAPTRAITS_H
+#define AISDI_MAPS_MAPTRAITS_H
+
+#include <type_traits>
+#include <utility>
+
+namespace aisdi
+{
+namespace detail
+{
+
+template <typename...>
+struct VoidType
+{
+  using type = void;
+};
+
+// A function object marked with is_transparent accepts any key-like type
+// (the C++14 convention used by std::less<> and std::equal_to<>).
+template <typename T, typename = void>
+struct IsTransparent : std::false_type
+{
+};
+
+template <typename T>
+struct IsTransparent<T, typename VoidType<typename T::is_transparent>::type> : std::true_type
+{
+};
+
+// Mapped type of the maps behind HashSet and TreeSet. With it a map stores
+// bare keys: value_type is the key itself rather than a pair.
+struct NoValue
+{
+};
+
+// What a map with the given key and mapped types keeps in its nodes.
+template <typename Key, typename Value>
+struct StoredValue
+{
+  using type = std::pair<Key, Value>;
+
+  static const Key &keyOf(const type &value)
+  {
+    return value.first;
+  }
+
+  template <typename K, typename V>
+  static type make(K &&key, V &&value)
+  {
+    return type(std::forward<K>(key), std::forward<V>(value));
+  }
+};
+
+template <typename Key>
+struct StoredValue<Key, NoValue>
+{
+  using type = Key;
+
+  static const Key &keyOf(const type &value)
+  {
+    return value;
+  }
+
+  template <typename K>
+  static type make(K &&key, NoValue)
+  {
+    return type(std::forward<K>(key));
+  }
+};
+
+// Containers that know their length, like std::list (but not ForwardChain).
+template <typename Container, typename = void>
+struct HasSize : std::false_type
+{
+};
+
+template <typename Container>
+struct HasSize<Container, typename VoidType<decltype(std::declval<const Container &>().size())>::type>
+    : std::true_type
+{
+};
+
+template <typename T, typename = void>
+struct IsLessComparable : std::false_type
+{
+};
+
+template <typename T>
+struct IsLessComparable<T, typename VoidType<decltype(std::declval<const T &>() < std::declval<const T &>())>::type>
+    : std::true_type
+{
+};
+
+// Ordered maps (TreeMap) name their comparator key_compare.
+template <typename Map, typename = void>
+struct IsOrderedMap : std::false_type
+{
+};
+
+template <typename Map>
+struct IsOrderedMap<Map, typename VoidType<typename Map::key_compare>::type> : std::true_type
+{
+};
+
+} // namespace detail
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_MAPTRAITS_H */
@@ -0,0 +1,247 @@
+#ifndef AISDI_MAPS_MAPPEDHASHMAP_H
+#define AISDI_MAPS_MAPPEDHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "FlatHashFile.h"
+
+namespace aisdi
+{
+
+// Writes map to path as a flat open addressing table that MappedHashMap
+// opens without parsing (see FlatHashFile.h). Keys and values have to be
+// trivially copyable, and the map has to expose its hasher through
+// hash_function(), as HashMap does. The file is replaced only once it is
+// complete and on disk.
+template <typename Map>
+void saveFlat(const Map &map, const std::string &path)
+{
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+
+  const auto hashFunction = map.hash_function();
+  detail::FlatFileWriter<key_type, mapped_type> writer(
+      path, map.getSize(), detail::flatHashFingerprint<typename Map::hasher, key_type>(hashFunction));
+  for (auto &item : map)
+    writer.insert(hashFunction(item.first), item.first, item.second);
+  writer.commit();
+}
+
+// Read-only view of a file written by saveFlat(). Opening maps the
+// file and checks its header, nothing is parsed or copied: lookups probe the
+// mapped slots directly, so pages are read from disk on first touch only and
+// every process that opens the same file shares one copy of them in the page
+// cache. Key, value and hash types have to match the ones that saved the file.
+//
+// Items are FlatEntry structs with first and second members, like the pairs
+// of the other maps. The view stays valid if the file is replaced by a newer
+// save, it keeps seeing the old one.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class MappedHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = detail::FlatEntry<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+  using iterator = ConstIterator;
+
+  explicit MappedHashMap(const std::string &path, const Hash &hashFunction = Hash(),
+                         const KeyEqual &keyEqual = KeyEqual())
+      : file(detail::FileMapping::openForReading(path)), hashFunction(hashFunction), keyEqual(keyEqual)
+  {
+    detail::checkFlatTypes<key_type, mapped_type>();
+    checkHeader(path);
+  }
+
+  MappedHashMap(MappedHashMap &&) = default;
+  MappedHashMap &operator=(MappedHashMap &&) = default;
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool contains(const key_type &key) const
+  {
+    return findSlot(key) != nullptr;
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    auto slot = findSlot(key);
+    return slot == nullptr ? end() : const_iterator(slot, slots + slotCount);
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    auto slot = findSlot(key);
+    if (slot == nullptr)
+      throw std::out_of_range("Key does not exists");
+    return slot->entry.second;
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(slots, slots + slotCount).skipEmpty();
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(slots + slotCount, slots + slotCount);
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  const_iterator cend() const
+  {
+    return end();
+  }
+
+private:
+  using slot_type = detail::FlatSlot<key_type, mapped_type>;
+
+  detail::FileMapping file;
+  const slot_type *slots = nullptr;
+  size_type slotCount = 0;
+  size_type size = 0;
+  Hash hashFunction;
+  KeyEqual keyEqual;
+
+  void checkHeader(const std::string &path)
+  {
+    detail::FlatHeader header;
+    if (file.getLength() < detail::flatDataOffset)
+      throw std::runtime_error("Not a flat hash map file: " + path);
+    std::memcpy(&header, file.bytes(), sizeof(header));
+
+    if (std::memcmp(header.magic, detail::flatMagic, sizeof(header.magic)) != 0)
+      throw std::runtime_error("Not a flat hash map file: " + path);
+    if (header.version != detail::flatVersion)
+      throw std::runtime_error("Unsupported flat hash map version in " + path);
+    if (header.byteOrder != detail::flatByteOrder || header.keySize != sizeof(key_type) ||
+        header.valueSize != sizeof(mapped_type) || header.slotSize != sizeof(slot_type) ||
+        header.slotAlignment != alignof(slot_type))
+      throw std::runtime_error("Flat hash map file holds other key or value types: " + path);
+    if (header.hashFingerprint != detail::flatHashFingerprint<Hash, key_type>(hashFunction))
+      throw std::runtime_error("Flat hash map file was saved with another hash function: " + path);
+    if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0 || header.size >= header.slotCount ||
+        (file.getLength() - detail::flatDataOffset) / sizeof(slot_type) < header.slotCount)
+      throw std::runtime_error("Flat hash map file is damaged or truncated: " + path);
+
+    slots = reinterpret_cast<const slot_type *>(file.bytes() + detail::flatDataOffset);
+    slotCount = static_cast<size_type>(header.slotCount);
+    size = static_cast<size_type>(header.size);
+  }
+
+  // Same probing as FlatFileWriter::insert; the table always has an empty slot.
+  const slot_type *findSlot(const key_type &key) const
+  {
+    auto tag = detail::flatTag(hashFunction(key));
+    auto index = static_cast<size_type>(tag >> 1) & (slotCount - 1);
+    while (slots[index].tag != 0)
+    {
+      if (slots[index].tag == tag && keyEqual(slots[index].entry.first, key))
+        return slots + index;
+      index = (index + 1) & (slotCount - 1);
+    }
+    return nullptr;
+  }
+};
+
+// Forward iterator over the occupied slots.
+template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+class MappedHashMap<KeyType, ValueType, Hash, KeyEqual>::ConstIterator
+{
+public:
+  using reference = typename MappedHashMap::const_reference;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename MappedHashMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type *;
+
+  ConstIterator() : slot(nullptr), last(nullptr)
+  {
+  }
+
+  ConstIterator(const slot_type *slot, const slot_type *last) : slot(slot), last(last)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (slot == last)
+      throw std::out_of_range("Incrementing end iterator");
+    ++slot;
+    return skipEmpty();
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (slot == last)
+      throw std::out_of_range("Dereferencing end iterator");
+    return slot->entry;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return slot == other.slot;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  friend class MappedHashMap;
+
+  const slot_type *slot;
+  const slot_type *last;
+
+  ConstIterator &skipEmpty()
+  {
+    while (slot != last && slot->tag == 0)
+      ++slot;
+    return *this;
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_MAPPEDHASHMAP_H */
@@ -0,0 +1,294 @@
+#ifndef AISDI_MAPS_POOLALLOCATOR_H
+#define AISDI_MAPS_POOLALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace aisdi
+{
+namespace detail
+{
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+// Free blocks of one size held by a single thread, so that allocating and
+// freeing take no lock. Trivially destructible and constant-initialized, so a
+// thread_local instance costs no guard on access and outlives every other
+// thread_local of its thread.
+struct NodeCache
+{
+  FreeBlock *freeList;
+  // last block of freeList, so that the whole list is handed over at once
+  FreeBlock *freeLast;
+  std::size_t count;
+  std::size_t slabBlocks;
+  // the thread has set up the release of this cache at its exit
+  bool registered;
+  // the thread is exiting: freed blocks go straight to the shared pool
+  bool released;
+};
+
+// Hands out fixed-size blocks carved from slabs to the caches of all threads.
+// A cache takes the blocks the pool holds when it runs dry, or a new slab if
+// there are none, and gives its blocks back when it holds too many or its
+// thread exits. Slabs are never given back to the system, so a map that
+// shrinks keeps its memory for later inserts, and a block freed by another
+// thread than the one that allocated it simply joins that thread's cache.
+class NodePool
+{
+public:
+  NodePool(std::size_t blockSize, std::size_t blockAlignment)
+      : blockSize(roundUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize,
+                          blockAlignment < alignof(FreeBlock) ? alignof(FreeBlock) : blockAlignment))
+  {
+  }
+
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  ~NodePool()
+  {
+    for (auto slab : slabs)
+      ::operator delete(slab);
+  }
+
+  // Called when cache is empty; fills it with at least one block.
+  void refill(NodeCache &cache)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      cache.freeList = freeList;
+      cache.freeLast = freeLast;
+      cache.count = freeCount;
+      freeList = freeLast = nullptr;
+      freeCount = 0;
+    }
+    if (cache.freeList == nullptr)
+      addSlab(cache);
+  }
+
+  // Moves every block of cache to the pool.
+  void flush(NodeCache &cache)
+  {
+    if (cache.freeList == nullptr)
+      return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.freeLast->next = freeList;
+    if (freeList == nullptr)
+      freeLast = cache.freeLast;
+    freeList = cache.freeList;
+    freeCount += cache.count;
+    cache.freeList = cache.freeLast = nullptr;
+    cache.count = 0;
+  }
+
+  void deallocateShared(void *pointer)
+  {
+    auto block = static_cast<FreeBlock *>(pointer);
+    std::lock_guard<std::mutex> lock(mutex);
+    block->next = freeList;
+    if (freeList == nullptr)
+      freeLast = block;
+    freeList = block;
+    ++freeCount;
+  }
+
+  // Bytes taken from the system so far.
+  std::size_t reservedBytes()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reserved;
+  }
+
+  // A cache holding more blocks than this gives all of them back, so that
+  // memory freed by one thread can serve the allocations of another.
+  static const std::size_t maxCachedBlocks = 128 * 1024;
+
+private:
+  static const std::size_t firstSlabBlocks = 64;
+  static const std::size_t maxSlabBlocks = 64 * 1024;
+
+  static std::size_t roundUp(std::size_t size, std::size_t alignment)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  // Slabs grow geometrically per thread, so small maps stay small and big
+  // ones need few slabs.
+  void addSlab(NodeCache &cache)
+  {
+    if (cache.slabBlocks == 0)
+      cache.slabBlocks = firstSlabBlocks;
+    const std::size_t bytes = cache.slabBlocks * blockSize;
+    auto slab = static_cast<char *>(::operator new(bytes));
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slabs.push_back(slab);
+      reserved += bytes;
+    }
+
+    // called on an empty cache
+    cache.freeLast = reinterpret_cast<FreeBlock *>(slab + (cache.slabBlocks - 1) * blockSize);
+    for (std::size_t i = cache.slabBlocks; i > 0; --i)
+    {
+      auto block = reinterpret_cast<FreeBlock *>(slab + (i - 1) * blockSize);
+      block->next = cache.freeList;
+      cache.freeList = block;
+    }
+    cache.count = cache.slabBlocks;
+
+    if (cache.slabBlocks < maxSlabBlocks)
+      cache.slabBlocks *= 2;
+  }
+
+  std::mutex mutex;
+  std::size_t blockSize;
+  std::size_t reserved = 0;
+  FreeBlock *freeList = nullptr;
+  FreeBlock *freeLast = nullptr;
+  std::size_t freeCount = 0;
+  std::vector<char *> slabs;
+};
+
+// Gives the blocks of a thread's cache back to the pool when the thread exits.
+class NodeCacheRelease
+{
+public:
+  NodeCacheRelease(NodeCache &cache, NodePool &pool) : cache(cache), pool(pool)
+  {
+  }
+
+  NodeCacheRelease(const NodeCacheRelease &) = delete;
+  NodeCacheRelease &operator=(const NodeCacheRelease &) = delete;
+
+  ~NodeCacheRelease()
+  {
+    cache.released = true;
+    pool.flush(cache);
+  }
+
+private:
+  NodeCache &cache;
+  NodePool &pool;
+};
+
+} // namespace detail
+
+// Stateless allocator that serves single objects from a pool shared by every
+// PoolAllocator<T> of the same T, through a cache per thread, so maps using it
+// can be modified from any number of threads as long as each map is used by
+// one at a time. Arrays and over-aligned types are passed to std::allocator.
+template <typename T>
+class PoolAllocator
+{
+public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = PoolAllocator<U>;
+  };
+
+  PoolAllocator() = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &)
+  {
+  }
+
+  T *allocate(std::size_t n)
+  {
+    if (n != 1 || !isPooled())
+      return std::allocator<T>{}.allocate(n);
+
+    auto &local = cache();
+    if (local.freeList == nullptr)
+      refill(local);
+    auto block = local.freeList;
+    local.freeList = block->next;
+    --local.count;
+    return reinterpret_cast<T *>(block);
+  }
+
+  void deallocate(T *pointer, std::size_t n)
+  {
+    if (n != 1 || !isPooled())
+    {
+      std::allocator<T>{}.deallocate(pointer, n);
+      return;
+    }
+
+    auto &local = cache();
+    if (local.released)
+    {
+      pool().deallocateShared(pointer);
+      return;
+    }
+    auto block = reinterpret_cast<detail::FreeBlock *>(pointer);
+    block->next = local.freeList;
+    if (local.freeList == nullptr)
+      local.freeLast = block;
+    local.freeList = block;
+    if (++local.count > detail::NodePool::maxCachedBlocks)
+      pool().flush(local);
+  }
+
+  static std::size_t reservedBytes()
+  {
+    return pool().reservedBytes();
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U> &) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U> &) const
+  {
+    return false;
+  }
+
+private:
+  static bool isPooled()
+  {
+    return alignof(T) <= alignof(std::max_align_t);
+  }
+
+  // Never destroyed, so that maps with static storage duration can still
+  // release their nodes after this function's statics would have been torn down.
+  static detail::NodePool &pool()
+  {
+    static auto instance = new detail::NodePool(sizeof(T), alignof(T));
+    return *instance;
+  }
+
+  static detail::NodeCache &cache()
+  {
+    static thread_local detail::NodeCache instance = { nullptr, nullptr, 0, 0, false, false };
+    return instance;
+  }
+
+  static void refill(detail::NodeCache &local)
+  {
+    if (!local.registered)
+    {
+      static thread_local detail::NodeCacheRelease release(local, pool());
+      local.registered = true;
+    }
+    pool().refill(local);
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_POOLALLOCATOR_H */
@@ -0,0 +1,586 @@
+#ifndef AISDI_MAPS_ROBINHOODHASHMAP_H
+#define AISDI_MAPS_ROBINHOODHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Linear probing with Robin Hood displacement: an inserted entry takes the slot
+// of any resident that is closer to its home bucket. Every slot remembers its
+// probe distance, so a lookup can stop as soon as it meets an entry that is
+// closer to home than the searched key would be. Removal shifts the following
+// cluster one slot back instead of leaving tombstones.
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  RobinHoodHashMap() = default;
+
+  RobinHoodHashMap(std::initializer_list<value_type> list)
+  {
+    reserveFor(list.size());
+    for (auto &item : list)
+      tryEmplace(item.first, item.second);
+  }
+
+  RobinHoodHashMap(const RobinHoodHashMap &other)
+  {
+    if (other.capacity == 0)
+      return;
+
+    allocate(other.capacity);
+    distances = other.distances;
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (distances[i] == 0)
+        continue;
+      try
+      {
+        new (slots + i) value_type(other.slots[i]);
+      }
+      catch (...)
+      {
+        // only the slots before i were made
+        std::fill(distances.begin() + i, distances.end(), distance_type(0));
+        release();
+        throw;
+      }
+    }
+    size = other.size;
+  }
+
+  RobinHoodHashMap(RobinHoodHashMap &&other) noexcept
+  {
+    swap(other);
+  }
+
+  RobinHoodHashMap &operator=(const RobinHoodHashMap &other)
+  {
+    if (this != &other)
+    {
+      RobinHoodHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  RobinHoodHashMap &operator=(RobinHoodHashMap &&other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~RobinHoodHashMap()
+  {
+    release();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type &operator[](const key_type &key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  mapped_type &operator[](key_type &&key)
+  {
+    return tryEmplace(std::move(key)).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+  {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+  {
+    return insertOrAssign(key, std::forward<M>(value));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+  {
+    return insertOrAssign(std::move(key), std::forward<M>(value));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return tryEmplace(std::move(value.first), std::move(value.second));
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    const_iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  mapped_type &valueOf(const key_type &key)
+  {
+    iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    return const_iterator(this, findIndex(key, hashOf(key)));
+  }
+
+  iterator find(const key_type &key)
+  {
+    return iterator(const_iterator(this, findIndex(key, hashOf(key))));
+  }
+
+  void remove(const key_type &key)
+  {
+    auto index = findIndex(key, hashOf(key));
+    if (index == capacity)
+      throw std::out_of_range("Removing non existing key");
+
+    eraseAt(index);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const RobinHoodHashMap &other) const
+  {
+    if (size != other.size)
+      return false;
+
+    for (auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const RobinHoodHashMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return const_iterator(this, nextFull(0));
+  }
+
+  const_iterator cend() const
+  {
+    return const_iterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  // distances[i] == 0 marks an empty slot, otherwise it is the probe distance + 1
+  using distance_type = std::uint8_t;
+
+  enum : size_type
+  {
+    initialCapacity = 8,
+    maxDistance = 255
+  };
+
+  std::vector<distance_type> distances;
+  value_type *slots = nullptr;
+  size_type capacity = 0;
+  size_type size = 0;
+
+  static size_type maxLoad(size_type capacity)
+  {
+    return capacity * 9 / 10;
+  }
+
+  static std::uint64_t hashOf(const key_type &key)
+  {
+    return detail::mixHash(std::hash<key_type>{}(key));
+  }
+
+  size_type homeOf(std::uint64_t hash) const
+  {
+    return static_cast<size_type>(hash) & (capacity - 1);
+  }
+
+  size_type findIndex(const key_type &key, std::uint64_t hash) const
+  {
+    if (capacity == 0)
+      return capacity;
+
+    auto index = homeOf(hash);
+    // a resident closer to its home than we are means the key is not present
+    for (size_type distance = 1; distances[index] >= distance; ++distance)
+    {
+      if (slots[index].first == key)
+        return index;
+      index = (index + 1) & (capacity - 1);
+    }
+    return capacity;
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+  {
+    const auto h = hashOf(key);
+    auto index = findIndex(key, h);
+    if (index != capacity)
+      return { iterator(const_iterator(this, index)), false };
+
+    // built before growing, as the arguments may refer to items of this map
+    value_type value(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    if (size + 1 > maxLoad(capacity))
+      rehash(capacity == 0 ? initialCapacity : capacity * 2);
+
+    index = insertUnique(std::move(value), h);
+    return { iterator(const_iterator(this, index)), true };
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K &&key, M &&value)
+  {
+    auto result = tryEmplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  // Places a key known to be absent and returns the slot where it landed.
+  size_type insertUnique(value_type &&value, std::uint64_t hash)
+  {
+    auto index = homeOf(hash);
+    size_type distance = 1;
+    size_type result = capacity;
+
+    value_type carried(std::move(value));
+    while (true)
+    {
+      if (distances[index] == 0)
+      {
+        new (slots + index) value_type(std::move(carried));
+        distances[index] = static_cast<distance_type>(distance);
+        ++size;
+        return result == capacity ? index : result;
+      }
+
+      if (distances[index] < distance)
+      {
+        using std::swap;
+        swap(carried, slots[index]);
+        auto displaced = distances[index];
+        distances[index] = static_cast<distance_type>(distance);
+        distance = displaced;
+        if (result == capacity)
+          result = index;
+      }
+
+      index = (index + 1) & (capacity - 1);
+      if (++distance == maxDistance)
+      {
+        // pathological clustering, spread the entries over a bigger table
+        if (result == capacity)
+        {
+          rehash(capacity * 2);
+          return insertUnique(std::move(carried), hash);
+        }
+
+        // the new entry is already placed: take it out again, so that it can
+        // be tracked through the rehash
+        value_type inserted(std::move(slots[result]));
+        eraseAt(result);
+        rehash(capacity * 2);
+        insertUnique(std::move(carried), hashOf(carried.first));
+        return insertUnique(std::move(inserted), hash);
+      }
+    }
+  }
+
+  void eraseAt(size_type index)
+  {
+    slots[index].~value_type();
+    --size;
+
+    auto next = (index + 1) & (capacity - 1);
+    while (distances[next] > 1)
+    {
+      new (slots + index) value_type(std::move(slots[next]));
+      slots[next].~value_type();
+      distances[index] = static_cast<distance_type>(distances[next] - 1);
+      index = next;
+      next = (next + 1) & (capacity - 1);
+    }
+    distances[index] = 0;
+  }
+
+  void reserveFor(size_type count)
+  {
+    size_type newCapacity = initialCapacity;
+    while (maxLoad(newCapacity) < count)
+      newCapacity *= 2;
+    if (newCapacity > capacity)
+      rehash(newCapacity);
+  }
+
+  void allocate(size_type newCapacity)
+  {
+    distances.assign(newCapacity, 0);
+    slots = std::allocator<value_type>{}.allocate(newCapacity);
+    capacity = newCapacity;
+  }
+
+  void rehash(size_type newCapacity)
+  {
+    RobinHoodHashMap fresh;
+    fresh.allocate(newCapacity);
+
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (distances[i] != 0)
+        fresh.insertUnique(std::move(slots[i]), hashOf(slots[i].first));
+    }
+
+    swap(fresh);
+  }
+
+  void release()
+  {
+    if (slots == nullptr)
+      return;
+
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (distances[i] != 0)
+        slots[i].~value_type();
+    }
+    std::allocator<value_type>{}.deallocate(slots, capacity);
+    slots = nullptr;
+    distances.clear();
+    capacity = size = 0;
+  }
+
+  void swap(RobinHoodHashMap &other) noexcept
+  {
+    std::swap(distances, other.distances);
+    std::swap(slots, other.slots);
+    std::swap(capacity, other.capacity);
+    std::swap(size, other.size);
+  }
+
+  size_type nextFull(size_type index) const
+  {
+    while (index < capacity && distances[index] == 0)
+      ++index;
+    return index;
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename RobinHoodHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename RobinHoodHashMap::value_type;
+  using pointer = const typename RobinHoodHashMap::value_type *;
+  using size_type = typename RobinHoodHashMap::size_type;
+
+  explicit ConstIterator(const RobinHoodHashMap *map, size_type index) : map(map), index(index)
+  {
+  }
+
+  ConstIterator(const ConstIterator &other) : map(other.map), index(other.index)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Incrementing end iterator");
+
+    index = map->nextFull(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    operator++();
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    auto previous = index;
+    while (previous > 0)
+    {
+      if (map->distances[--previous] != 0)
+      {
+        index = previous;
+        return *this;
+      }
+    }
+    throw std::out_of_range("Decrementing begin iterator");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Dereferencing end iterator");
+    return map->slots[index];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return index == other.index;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+  const RobinHoodHashMap *map;
+  size_type index;
+};
+
+template <typename KeyType, typename ValueType>
+class RobinHoodHashMap<KeyType, ValueType>::Iterator : public RobinHoodHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename RobinHoodHashMap::reference;
+  using pointer = typename RobinHoodHashMap::value_type *;
+
+  Iterator(const ConstIterator &other)
+      : ConstIterator(other)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_ROBINHOODHASHMAP_H */
@@ -0,0 +1,655 @@
+#ifndef AISDI_MAPS_SMALLMAP_H
+#define AISDI_MAPS_SMALLMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "HashMap.h"
+#include "MapTraits.h"
+#include "TreeMap.h"
+
+namespace aisdi
+{
+
+// Small-buffer front for HashMap or TreeMap. The first N items live inline,
+// in an array inside the object, and are found by a linear scan; neither
+// creating nor filling the map up to N items allocates. Inserting item N + 1
+// moves everything into a Map built in the same storage, which serves all
+// operations from then on, even if the map shrinks again.
+//
+// Over a TreeMap the inline items are kept sorted, so iteration is ordered in
+// both modes. Over a HashMap removal moves the last inline item into the hole.
+// Like in a vector, inline inserts and removals invalidate iterators and
+// references to inline items. Map's key_compare or key_equal is default
+// constructed wherever it is needed.
+template <typename Map, std::size_t N = 16>
+class SmallMap
+{
+  static_assert(N > 0, "SmallMap needs room for at least one inline item");
+
+public:
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using map_type = Map;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  static const size_type inlineCapacity = N;
+
+  SmallMap()
+  {
+  }
+
+  SmallMap(std::initializer_list<value_type> list)
+  {
+    for (auto &item : list)
+      tryEmplace(item.first, item.second);
+  }
+
+  SmallMap(const SmallMap &other)
+  {
+    if (other.spilled)
+    {
+      new (&storage) Map(other.large());
+      spilled = true;
+      return;
+    }
+    for (; inlineSize < other.inlineSize; ++inlineSize)
+      new (items() + inlineSize) value_type(other.items()[inlineSize]);
+  }
+
+  SmallMap(SmallMap &&other)
+  {
+    moveFrom(other);
+  }
+
+  SmallMap &operator=(const SmallMap &other)
+  {
+    if (this != &other)
+    {
+      SmallMap copy(other);
+      release();
+      moveFrom(copy);
+    }
+    return *this;
+  }
+
+  SmallMap &operator=(SmallMap &&other)
+  {
+    if (this != &other)
+    {
+      release();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  ~SmallMap()
+  {
+    release();
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // True while the items are still stored inline.
+  bool isSmall() const
+  {
+    return !spilled;
+  }
+
+  mapped_type &operator[](const key_type &key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  mapped_type &operator[](key_type &&key)
+  {
+    return tryEmplace(std::move(key)).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+  {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+  {
+    return insertOrAssign(key, std::forward<M>(value));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+  {
+    return insertOrAssign(std::move(key), std::forward<M>(value));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return tryEmplace(std::move(value.first), std::move(value.second));
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    const_iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  mapped_type &valueOf(const key_type &key)
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<mapped_type &>(static_cast<const SmallMap &>(*this).valueOf(key));
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    if (spilled)
+      return const_iterator(this, large().find(key));
+
+    auto position = inlinePosition(key);
+    return const_iterator(this, isMatch(position, key) ? position : inlineSize);
+  }
+
+  iterator find(const key_type &key)
+  {
+    return iterator(static_cast<const SmallMap &>(*this).find(key));
+  }
+
+  void remove(const key_type &key)
+  {
+    if (spilled)
+    {
+      large().remove(key);
+      return;
+    }
+
+    auto position = inlinePosition(key);
+    if (!isMatch(position, key))
+      throw std::out_of_range("Removing non existing key");
+    eraseInline(position);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    if (spilled)
+      large().remove(it.largeIterator());
+    else
+      eraseInline(it.position);
+  }
+
+  size_type getSize() const
+  {
+    return spilled ? large().getSize() : inlineSize;
+  }
+
+  bool operator==(const SmallMap &other) const
+  {
+    if (getSize() != other.getSize())
+      return false;
+
+    for (auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SmallMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return spilled ? const_iterator(this, large().cbegin()) : const_iterator(this, 0);
+  }
+
+  const_iterator cend() const
+  {
+    return spilled ? const_iterator(this, large().cend()) : const_iterator(this, inlineSize);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  using Ordered = detail::IsOrderedMap<Map>;
+
+  static constexpr std::size_t storageSize = std::max(sizeof(value_type) * N, sizeof(Map));
+  static constexpr std::size_t storageAlignment = std::max(alignof(value_type), alignof(Map));
+
+  // the inline items until the map spills, the Map afterwards
+  typename std::aligned_storage<storageSize, storageAlignment>::type storage;
+  size_type inlineSize = 0;
+  bool spilled = false;
+
+  value_type *items()
+  {
+    return reinterpret_cast<value_type *>(&storage);
+  }
+
+  const value_type *items() const
+  {
+    return reinterpret_cast<const value_type *>(&storage);
+  }
+
+  Map &large()
+  {
+    return *reinterpret_cast<Map *>(&storage);
+  }
+
+  const Map &large() const
+  {
+    return *reinterpret_cast<const Map *>(&storage);
+  }
+
+  // Ordered: the first item not less than key. Otherwise: the item equal to
+  // key, or inlineSize if there is none.
+  size_type inlinePosition(const key_type &key) const
+  {
+    return inlinePosition(key, Ordered());
+  }
+
+  size_type inlinePosition(const key_type &key, std::true_type) const
+  {
+    typename Map::key_compare less;
+    size_type position = 0;
+    while (position < inlineSize && less(items()[position].first, key))
+      ++position;
+    return position;
+  }
+
+  size_type inlinePosition(const key_type &key, std::false_type) const
+  {
+    typename Map::key_equal equal;
+    size_type position = 0;
+    while (position < inlineSize && !equal(items()[position].first, key))
+      ++position;
+    return position;
+  }
+
+  bool isMatch(size_type position, const key_type &key) const
+  {
+    return isMatch(position, key, Ordered());
+  }
+
+  bool isMatch(size_type position, const key_type &key, std::true_type) const
+  {
+    return position < inlineSize && !typename Map::key_compare()(key, items()[position].first);
+  }
+
+  bool isMatch(size_type position, const key_type &, std::false_type) const
+  {
+    return position < inlineSize;
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+  {
+    if (spilled)
+    {
+      auto result = large().try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+      return { iterator(const_iterator(this, result.first)), result.second };
+    }
+
+    auto position = inlinePosition(key);
+    if (isMatch(position, key))
+      return { iterator(const_iterator(this, position)), false };
+
+    if (inlineSize == N)
+    {
+      // built before spilling, as the arguments may refer to inline items
+      value_type value(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+      spill();
+      auto result = large().try_emplace(std::move(value.first), std::move(value.second));
+      return { iterator(const_iterator(this, result.first)), result.second };
+    }
+
+    new (items() + inlineSize) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                                          std::forward_as_tuple(std::forward<Args>(args)...));
+    ++inlineSize;
+    // appended unordered items are already in place
+    std::rotate(items() + position, items() + inlineSize - 1, items() + inlineSize);
+    return { iterator(const_iterator(this, position)), true };
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K &&key, M &&value)
+  {
+    auto result = tryEmplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  void eraseInline(size_type position)
+  {
+    eraseInline(position, Ordered());
+  }
+
+  void eraseInline(size_type position, std::true_type)
+  {
+    std::move(items() + position + 1, items() + inlineSize, items() + position);
+    items()[--inlineSize].~value_type();
+  }
+
+  void eraseInline(size_type position, std::false_type)
+  {
+    if (position != inlineSize - 1)
+      items()[position] = std::move(items()[inlineSize - 1]);
+    items()[--inlineSize].~value_type();
+  }
+
+  void spill()
+  {
+    Map map;
+    for (size_type i = 0; i < inlineSize; ++i)
+      map.try_emplace(std::move(items()[i].first), std::move(items()[i].second));
+
+    destroyInline();
+    new (&storage) Map(std::move(map));
+    spilled = true;
+  }
+
+  void destroyInline()
+  {
+    for (size_type i = 0; i < inlineSize; ++i)
+      items()[i].~value_type();
+    inlineSize = 0;
+  }
+
+  void release()
+  {
+    if (spilled)
+    {
+      large().~Map();
+      spilled = false;
+    }
+    else
+      destroyInline();
+  }
+
+  // Leaves other empty and inline.
+  void moveFrom(SmallMap &other)
+  {
+    if (other.spilled)
+    {
+      new (&storage) Map(std::move(other.large()));
+      spilled = true;
+    }
+    else
+    {
+      for (; inlineSize < other.inlineSize; ++inlineSize)
+        new (items() + inlineSize) value_type(std::move(other.items()[inlineSize]));
+    }
+    other.release();
+  }
+};
+
+template <typename Map, std::size_t N>
+const typename SmallMap<Map, N>::size_type SmallMap<Map, N>::inlineCapacity;
+
+template <typename Map, std::size_t N>
+constexpr std::size_t SmallMap<Map, N>::storageSize;
+
+template <typename Map, std::size_t N>
+constexpr std::size_t SmallMap<Map, N>::storageAlignment;
+
+// Points either at an inline position or, once the map spilled, holds an
+// iterator of the Map. The latter may be neither default constructible nor
+// assignable (TreeMap's is not), so it is kept in raw storage.
+template <typename Map, std::size_t N>
+class SmallMap<Map, N>::ConstIterator
+{
+public:
+  using reference = typename SmallMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename SmallMap::value_type;
+  using pointer = const typename SmallMap::value_type *;
+  using size_type = typename SmallMap::size_type;
+  using large_iterator = typename Map::const_iterator;
+
+  // storage is zeroed only to keep the compiler from seeing reads of it as uninitialized
+  explicit ConstIterator(const SmallMap *map, size_type position) : map(map), position(position), storage()
+  {
+  }
+
+  explicit ConstIterator(const SmallMap *map, const large_iterator &it) : map(map), position(0), inLarge(true)
+  {
+    new (&storage) large_iterator(it);
+  }
+
+  ConstIterator(const ConstIterator &other)
+      : map(other.map), position(other.position), inLarge(other.inLarge), storage()
+  {
+    if (inLarge)
+      new (&storage) large_iterator(other.largeIterator());
+  }
+
+  ConstIterator &operator=(const ConstIterator &other)
+  {
+    if (this != &other)
+    {
+      reset();
+      map = other.map;
+      position = other.position;
+      if (other.inLarge)
+      {
+        new (&storage) large_iterator(other.largeIterator());
+        inLarge = true;
+      }
+    }
+    return *this;
+  }
+
+  ~ConstIterator()
+  {
+    reset();
+  }
+
+  ConstIterator &operator++()
+  {
+    if (inLarge)
+    {
+      ++largeIterator();
+      return *this;
+    }
+
+    if (position >= map->inlineSize)
+      throw std::out_of_range("Incrementing end iterator");
+    ++position;
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    operator++();
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    if (inLarge)
+    {
+      --largeIterator();
+      return *this;
+    }
+
+    if (position == 0)
+      throw std::out_of_range("Decrementing begin iterator");
+    --position;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (inLarge)
+      return *largeIterator();
+
+    if (position >= map->inlineSize)
+      throw std::out_of_range("Dereferencing end iterator");
+    return map->items()[position];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    if (inLarge != other.inLarge)
+      return false;
+    return inLarge ? largeIterator() == other.largeIterator() : position == other.position;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+  const large_iterator &largeIterator() const
+  {
+    return *reinterpret_cast<const large_iterator *>(&storage);
+  }
+
+  large_iterator &largeIterator()
+  {
+    return *reinterpret_cast<large_iterator *>(&storage);
+  }
+
+  const SmallMap *map;
+  size_type position;
+
+private:
+  bool inLarge = false;
+  typename std::aligned_storage<sizeof(large_iterator), alignof(large_iterator)>::type storage;
+
+  void reset()
+  {
+    if (inLarge)
+    {
+      largeIterator().~large_iterator();
+      inLarge = false;
+    }
+  }
+};
+
+template <typename Map, std::size_t N>
+class SmallMap<Map, N>::Iterator : public SmallMap<Map, N>::ConstIterator
+{
+public:
+  using reference = typename SmallMap::reference;
+  using pointer = typename SmallMap::value_type *;
+
+  Iterator(const ConstIterator &other)
+      : ConstIterator(other)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+template <typename KeyType, typename ValueType, std::size_t N = 16>
+using SmallHashMap = SmallMap<HashMap<KeyType, ValueType>, N>;
+
+template <typename KeyType, typename ValueType, std::size_t N = 16>
+using SmallTreeMap = SmallMap<TreeMap<KeyType, ValueType>, N>;
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_SMALLMAP_H */
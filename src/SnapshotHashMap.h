@@ -0,0 +1,176 @@
+#ifndef AISDI_MAPS_SNAPSHOTHASHMAP_H
+#define AISDI_MAPS_SNAPSHOTHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include "EpochReclaimer.h"
+#include "HashMap.h"
+
+namespace aisdi
+{
+
+// Thread-safe map for read-mostly data, RCU style. Readers look up in the
+// current snapshot, an immutable HashMap reached through one atomic pointer.
+// Writers copy the snapshot, change the copy and publish it with a single
+// pointer store; the old snapshot is freed once no reader can still be in it
+// (see EpochReclaimer.h).
+//
+// A reader takes no lock and does no read-modify-write. Apart from the
+// lookup itself it only loads the pointer and flags its own epoch record,
+// so readers on different cores never write to a shared cache line.
+// Every change copies the whole table: batch changes with update() or build
+// a new table and publish() it.
+template <typename KeyType, typename ValueType,
+          typename Hash = std::hash<KeyType>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class SnapshotHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using map_type = HashMap<KeyType, ValueType, Hash, KeyEqual>;
+
+  SnapshotHashMap() : current(new map_type())
+  {
+  }
+
+  explicit SnapshotHashMap(map_type map) : current(new map_type(std::move(map)))
+  {
+  }
+
+  SnapshotHashMap(const SnapshotHashMap &) = delete;
+  SnapshotHashMap &operator=(const SnapshotHashMap &) = delete;
+
+  // No other thread may use the map any more.
+  ~SnapshotHashMap()
+  {
+    delete current.load();
+  }
+
+  // Calls reader(const map_type &) on the current snapshot and returns its
+  // result. The snapshot stays alive and unchanged until reader returns, so
+  // several lookups or an iteration inside one call see the same version.
+  template <typename Reader>
+  auto read(Reader reader) const -> decltype(reader(std::declval<const map_type &>()))
+  {
+    Guard guard;
+    return reader(static_cast<const map_type &>(*current.load(std::memory_order_acquire)));
+  }
+
+  // Copies the value of key to value. Returns false if there is no such key.
+  bool find(const key_type &key, mapped_type &value) const
+  {
+    return read([&](const map_type &map) {
+      auto it = map.find(key);
+      if (it == map.end())
+        return false;
+      value = it->second;
+      return true;
+    });
+  }
+
+  mapped_type valueOf(const key_type &key) const
+  {
+    return read([&](const map_type &map) { return map.valueOf(key); });
+  }
+
+  bool contains(const key_type &key) const
+  {
+    return read([&](const map_type &map) { return map.find(key) != map.end(); });
+  }
+
+  size_type getSize() const
+  {
+    return read([](const map_type &map) { return map.getSize(); });
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // Replaces the whole content. Readers see either the old or the new table.
+  void publish(map_type map)
+  {
+    auto fresh = new map_type(std::move(map));
+    std::lock_guard<std::mutex> lock(writerMutex);
+    replace(fresh);
+  }
+
+  // Calls writer(map_type &) on a copy of the current snapshot and publishes
+  // the copy. Writers are serialized, so no update is lost.
+  template <typename Writer>
+  void update(Writer writer)
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    auto fresh = new map_type(*current.load());
+    try
+    {
+      writer(*fresh);
+    }
+    catch (...)
+    {
+      delete fresh;
+      throw;
+    }
+    replace(fresh);
+  }
+
+  // Inserts the value or, if the key is present, assigns it. Returns true if inserted.
+  bool upsert(const key_type &key, const mapped_type &value)
+  {
+    bool inserted = false;
+    update([&](map_type &map) { inserted = map.insert_or_assign(key, value).second; });
+    return inserted;
+  }
+
+  // Returns true if removed. Publishes nothing if the key is missing.
+  bool remove(const key_type &key)
+  {
+    if (!contains(key))
+      return false;
+
+    bool removed = false;
+    update([&](map_type &map) {
+      auto it = map.find(key);
+      if (it == map.end())
+        return;
+      map.remove(it);
+      removed = true;
+    });
+    return removed;
+  }
+
+private:
+  using Guard = detail::EpochReclaimer::Guard;
+
+  std::atomic<map_type *> current;
+  std::mutex writerMutex;
+
+  static void deleteMap(void *map)
+  {
+    delete static_cast<map_type *>(map);
+  }
+
+  // Has to be called with writerMutex held.
+  void replace(map_type *fresh)
+  {
+    {
+      Guard guard;
+      auto old = current.exchange(fresh, std::memory_order_acq_rel);
+      detail::EpochReclaimer::instance().retire(old, &deleteMap);
+    }
+    // writes are rare, so free old snapshots now rather than after many more
+    detail::EpochReclaimer::instance().flush();
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_SNAPSHOTHASHMAP_H */
@@ -0,0 +1,712 @@
+#ifndef AISDI_MAPS_STRINGHASHMAP_H
+#define AISDI_MAPS_STRINGHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Bytes of a string key, not owned. StringHashMap takes keys as StringKey,
+// so both std::string and C strings are looked up without a copy, and hands
+// its own keys out as StringKey pointing into its arena; those are valid
+// until the next insert or removal, like the iterators they came from.
+class StringKey
+{
+public:
+  StringKey(const std::string &key) : bytes(key.data()), length(key.size())
+  {
+  }
+
+  StringKey(const char *key) : bytes(key), length(std::strlen(key))
+  {
+  }
+
+  StringKey(const char *data, std::size_t size) : bytes(data), length(size)
+  {
+  }
+
+  const char *data() const
+  {
+    return bytes;
+  }
+
+  std::size_t size() const
+  {
+    return length;
+  }
+
+  std::string str() const
+  {
+    return std::string(bytes, length);
+  }
+
+  friend bool operator==(const StringKey &lhs, const StringKey &rhs)
+  {
+    return lhs.length == rhs.length && (lhs.length == 0 || std::memcmp(lhs.bytes, rhs.bytes, lhs.length) == 0);
+  }
+
+  friend bool operator!=(const StringKey &lhs, const StringKey &rhs)
+  {
+    return !(lhs == rhs);
+  }
+
+private:
+  const char *bytes;
+  std::size_t length;
+};
+
+namespace detail
+{
+
+// Gives operator-> to iterators whose items are built on the fly.
+template <typename Reference>
+class ArrowProxy
+{
+public:
+  explicit ArrowProxy(const Reference &item) : item(item)
+  {
+  }
+
+  const Reference *operator->() const
+  {
+    return &item;
+  }
+
+private:
+  Reference item;
+};
+
+} // namespace detail
+
+// HashMap specialized for std::string keys. The key bytes are appended to one
+// arena shared by all items, so inserting does not allocate a string buffer;
+// a slot keeps only the key's offset in the arena, its length and a 32-bit
+// fingerprint of its hash, and values sit in an array of their own. Lookups
+// compare the fingerprint and the length before touching the arena.
+//
+// Slots are placed with Robin Hood linear probing (see RobinHoodHashMap). The
+// home slot of a key is given by the top bits of its fingerprint, so growing
+// the table moves slots without reading a single key again. Removed keys
+// leave their bytes in the arena until they make up half of it; it is then
+// compacted.
+//
+// Items are pairs of a StringKey and a reference to the value, made when the
+// iterator is dereferenced: iterate with auto or const auto &.
+template <typename ValueType>
+class StringHashMap
+{
+public:
+  using key_type = std::string;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = std::pair<StringKey, mapped_type &>;
+  using const_reference = std::pair<StringKey, const mapped_type &>;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  StringHashMap() = default;
+
+  StringHashMap(std::initializer_list<value_type> list)
+  {
+    reserve(list.size());
+    for (auto &item : list)
+      tryEmplace(item.first, item.second);
+  }
+
+  StringHashMap(const StringHashMap &other)
+      : arena(other.arena), deadBytes(other.deadBytes), slots(other.slots), shift(other.shift)
+  {
+    if (other.capacity == 0)
+      return;
+
+    values = std::allocator<mapped_type>{}.allocate(other.capacity);
+    capacity = other.capacity;
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (slots[i].fingerprint == 0)
+        continue;
+      try
+      {
+        new (values + i) mapped_type(other.values[i]);
+      }
+      catch (...)
+      {
+        // only the values before i were made
+        for (auto j = i; j < capacity; ++j)
+          slots[j].fingerprint = 0;
+        release();
+        throw;
+      }
+      ++size;
+    }
+  }
+
+  StringHashMap(StringHashMap &&other) noexcept
+  {
+    swap(other);
+  }
+
+  StringHashMap &operator=(const StringHashMap &other)
+  {
+    if (this != &other)
+    {
+      StringHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  StringHashMap &operator=(StringHashMap &&other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~StringHashMap()
+  {
+    release();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type &operator[](StringKey key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(StringKey key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(StringKey key, M &&value)
+  {
+    auto result = tryEmplace(key, std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  const mapped_type &valueOf(StringKey key) const
+  {
+    auto index = findIndex(key, fingerprintOf(key));
+    if (index == capacity)
+      throw std::out_of_range("Key does not exists");
+
+    return values[index];
+  }
+
+  mapped_type &valueOf(StringKey key)
+  {
+    return const_cast<mapped_type &>(static_cast<const StringHashMap &>(*this).valueOf(key));
+  }
+
+  const_iterator find(StringKey key) const
+  {
+    return const_iterator(this, findIndex(key, fingerprintOf(key)));
+  }
+
+  iterator find(StringKey key)
+  {
+    return iterator(const_iterator(this, findIndex(key, fingerprintOf(key))));
+  }
+
+  void remove(StringKey key)
+  {
+    auto index = findIndex(key, fingerprintOf(key));
+    if (index == capacity)
+      throw std::out_of_range("Removing non existing key");
+
+    eraseAt(index);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    eraseAt(it.index);
+  }
+
+  // Makes room for count items without growing the table again.
+  void reserve(size_type count)
+  {
+    size_type newCapacity = initialCapacity;
+    while (maxLoad(newCapacity) < count)
+      newCapacity *= 2;
+    if (newCapacity > capacity)
+      rehash(newCapacity);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const StringHashMap &other) const
+  {
+    if (size != other.size)
+      return false;
+
+    for (const auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const StringHashMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return const_iterator(this, nextFull(0));
+  }
+
+  const_iterator cend() const
+  {
+    return const_iterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  // fingerprint == 0 marks an empty slot, the fingerprints of keys are odd.
+  // The key's offset takes 40 bits and its length the other 24, which keeps
+  // a slot at 12 bytes.
+  struct Slot
+  {
+    std::uint32_t fingerprint;
+    std::uint32_t offsetLow;
+    std::uint32_t lengthAndOffsetHigh;
+
+    std::uint64_t offset() const
+    {
+      return offsetLow | std::uint64_t(lengthAndOffsetHigh >> 24) << 32;
+    }
+
+    std::uint32_t length() const
+    {
+      return lengthAndOffsetHigh & maxKeyLength;
+    }
+
+    void setKey(std::uint64_t offset, std::size_t length)
+    {
+      offsetLow = static_cast<std::uint32_t>(offset);
+      lengthAndOffsetHigh = static_cast<std::uint32_t>(length | (offset >> 32) << 24);
+    }
+  };
+
+  enum : size_type
+  {
+    initialCapacity = 8,
+    maxKeyLength = (size_type(1) << 24) - 1,
+    maxArenaSize = size_type(1) << 40
+  };
+
+  std::vector<char> arena;
+  size_type deadBytes = 0;
+  std::vector<Slot> slots;
+  mapped_type *values = nullptr;
+  size_type capacity = 0;
+  size_type size = 0;
+  // 32 - log2(capacity): the home slot is the top bits of the fingerprint
+  unsigned shift = 32;
+
+  static size_type maxLoad(size_type capacity)
+  {
+    return capacity * 9 / 10;
+  }
+
+  static std::uint32_t fingerprintOf(StringKey key)
+  {
+    return static_cast<std::uint32_t>(detail::mixHash(detail::hashBytes(key.data(), key.size())) >> 32) | 1;
+  }
+
+  size_type homeOf(std::uint32_t fingerprint) const
+  {
+    return static_cast<size_type>(fingerprint >> shift);
+  }
+
+  size_type distanceOf(size_type index) const
+  {
+    return (index - homeOf(slots[index].fingerprint)) & (capacity - 1);
+  }
+
+  StringKey keyAt(size_type index) const
+  {
+    return StringKey(arena.data() + slots[index].offset(), slots[index].length());
+  }
+
+  size_type findIndex(StringKey key, std::uint32_t fingerprint) const
+  {
+    if (capacity == 0)
+      return capacity;
+
+    auto index = homeOf(fingerprint);
+    // a resident closer to its home than we are means the key is not present
+    for (size_type distance = 0;; ++distance)
+    {
+      const auto &slot = slots[index];
+      if (slot.fingerprint == 0 || distanceOf(index) < distance)
+        return capacity;
+      if (slot.fingerprint == fingerprint && slot.length() == key.size() &&
+          (key.size() == 0 || std::memcmp(arena.data() + slot.offset(), key.data(), key.size()) == 0))
+        return index;
+      index = (index + 1) & (capacity - 1);
+    }
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(StringKey key, Args &&... args)
+  {
+    const auto fingerprint = fingerprintOf(key);
+    auto index = findIndex(key, fingerprint);
+    if (index != capacity)
+      return { iterator(const_iterator(this, index)), false };
+
+    // built before growing, as the arguments may refer to values of this map
+    auto value = mapped_type(std::forward<Args>(args)...);
+    if (key.size() > maxKeyLength)
+      throw std::length_error("Key too long for StringHashMap");
+    if (arena.size() + key.size() > maxArenaSize)
+      throw std::length_error("StringHashMap has no room for more keys");
+    if (size + 1 > maxLoad(capacity))
+      rehash(capacity == 0 ? initialCapacity : capacity * 2);
+
+    Slot slot = { fingerprint, 0, 0 };
+    slot.setKey(appendKey(key), key.size());
+    index = insertUnique(slot, std::move(value));
+    return { iterator(const_iterator(this, index)), true };
+  }
+
+  // Copies the key to the end of the arena, even if it comes from the arena.
+  std::uint64_t appendKey(StringKey key)
+  {
+    const auto offset = arena.size();
+    const bool inArena = key.size() != 0 && key.data() >= arena.data() && key.data() < arena.data() + arena.size();
+    const auto source = inArena ? key.data() - arena.data() : 0;
+    arena.resize(offset + key.size());
+    if (key.size() != 0)
+      std::memcpy(arena.data() + offset, inArena ? arena.data() + source : key.data(), key.size());
+    return offset;
+  }
+
+  // Places a key known to be absent and returns the slot where it landed.
+  size_type insertUnique(Slot slot, mapped_type &&value)
+  {
+    auto index = homeOf(slot.fingerprint);
+    size_type distance = 0;
+    size_type result = capacity;
+
+    mapped_type carried(std::move(value));
+    while (true)
+    {
+      if (slots[index].fingerprint == 0)
+      {
+        new (values + index) mapped_type(std::move(carried));
+        slots[index] = slot;
+        ++size;
+        return result == capacity ? index : result;
+      }
+
+      auto residentDistance = distanceOf(index);
+      if (residentDistance < distance)
+      {
+        using std::swap;
+        swap(slot, slots[index]);
+        swap(carried, values[index]);
+        distance = residentDistance;
+        if (result == capacity)
+          result = index;
+      }
+
+      index = (index + 1) & (capacity - 1);
+      ++distance;
+    }
+  }
+
+  void eraseAt(size_type index)
+  {
+    deadBytes += slots[index].length();
+    values[index].~mapped_type();
+    --size;
+
+    auto next = (index + 1) & (capacity - 1);
+    while (slots[next].fingerprint != 0 && distanceOf(next) != 0)
+    {
+      new (values + index) mapped_type(std::move(values[next]));
+      values[next].~mapped_type();
+      slots[index] = slots[next];
+      index = next;
+      next = (next + 1) & (capacity - 1);
+    }
+    slots[index] = Slot();
+
+    if (deadBytes > arena.size() / 2)
+      compactArena();
+  }
+
+  void compactArena()
+  {
+    std::vector<char> compacted;
+    compacted.reserve(arena.size() - deadBytes);
+    for (auto &slot : slots)
+    {
+      if (slot.fingerprint == 0)
+        continue;
+      auto offset = compacted.size();
+      auto key = arena.begin() + slot.offset();
+      compacted.insert(compacted.end(), key, key + slot.length());
+      slot.setKey(offset, slot.length());
+    }
+    arena.swap(compacted);
+    deadBytes = 0;
+  }
+
+  // Moves the slots and values to a table of newCapacity slots; keys stay
+  // where they are in the arena and are not hashed again.
+  void rehash(size_type newCapacity)
+  {
+    if (newCapacity > (std::uint64_t(1) << 32))
+      throw std::length_error("StringHashMap cannot grow any more");
+
+    std::vector<Slot> oldSlots(newCapacity);
+    oldSlots.swap(slots);
+    auto oldValues = values;
+    auto oldCapacity = capacity;
+    values = std::allocator<mapped_type>{}.allocate(newCapacity);
+    capacity = newCapacity;
+    shift = 32 - detail::highestBitIndex(newCapacity);
+    size = 0;
+
+    for (size_type i = 0; i < oldCapacity; ++i)
+    {
+      if (oldSlots[i].fingerprint == 0)
+        continue;
+      insertUnique(oldSlots[i], std::move(oldValues[i]));
+      oldValues[i].~mapped_type();
+    }
+    if (oldValues != nullptr)
+      std::allocator<mapped_type>{}.deallocate(oldValues, oldCapacity);
+  }
+
+  void release()
+  {
+    if (values == nullptr)
+      return;
+
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (slots[i].fingerprint != 0)
+        values[i].~mapped_type();
+    }
+    std::allocator<mapped_type>{}.deallocate(values, capacity);
+    values = nullptr;
+    slots.clear();
+    arena.clear();
+    deadBytes = 0;
+    capacity = size = 0;
+    shift = 32;
+  }
+
+  void swap(StringHashMap &other) noexcept
+  {
+    arena.swap(other.arena);
+    std::swap(deadBytes, other.deadBytes);
+    slots.swap(other.slots);
+    std::swap(values, other.values);
+    std::swap(capacity, other.capacity);
+    std::swap(size, other.size);
+    std::swap(shift, other.shift);
+  }
+
+  size_type nextFull(size_type index) const
+  {
+    while (index < capacity && slots[index].fingerprint == 0)
+      ++index;
+    return index;
+  }
+};
+
+template <typename ValueType>
+class StringHashMap<ValueType>::ConstIterator
+{
+public:
+  using reference = typename StringHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename StringHashMap::value_type;
+  using pointer = detail::ArrowProxy<reference>;
+  using size_type = typename StringHashMap::size_type;
+
+  explicit ConstIterator(const StringHashMap *map, size_type index) : map(map), index(index)
+  {
+  }
+
+  ConstIterator(const ConstIterator &other) : map(other.map), index(other.index)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Incrementing end iterator");
+
+    index = map->nextFull(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    operator++();
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    auto previous = index;
+    while (previous > 0)
+    {
+      if (map->slots[--previous].fingerprint != 0)
+      {
+        index = previous;
+        return *this;
+      }
+    }
+    throw std::out_of_range("Decrementing begin iterator");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Dereferencing end iterator");
+    return reference(map->keyAt(index), map->values[index]);
+  }
+
+  pointer operator->() const
+  {
+    return pointer(this->operator*());
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return index == other.index;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+  const StringHashMap *map;
+  size_type index;
+};
+
+template <typename ValueType>
+class StringHashMap<ValueType>::Iterator : public StringHashMap<ValueType>::ConstIterator
+{
+public:
+  using reference = typename StringHashMap::reference;
+  using pointer = detail::ArrowProxy<reference>;
+
+  Iterator(const ConstIterator &other)
+      : ConstIterator(other)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return pointer(this->operator*());
+  }
+
+  reference operator*() const
+  {
+    auto item = ConstIterator::operator*();
+    // ugly cast, yet reduces code duplication.
+    return reference(item.first, const_cast<mapped_type &>(item.second));
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_STRINGHASHMAP_H */
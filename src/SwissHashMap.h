@@ -0,0 +1,661 @@
+#ifndef AISDI_MAPS_SWISSHASHMAP_H
+#define AISDI_MAPS_SWISSHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "HashUtils.h"
+
+namespace aisdi
+{
+
+// Open addressing table in the "Swiss table" style: every slot has one control
+// byte holding either a state (empty / deleted) or the low 7 bits of the hash
+// of its key. Probing inspects a whole group of 16 control bytes at once, so
+// most lookups touch one control cache line and a single slot.
+template <typename KeyType, typename ValueType>
+class SwissHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  SwissHashMap() = default;
+
+  SwissHashMap(std::initializer_list<value_type> list)
+  {
+    reserveFor(list.size());
+    for (auto &item : list)
+      tryEmplace(item.first, item.second);
+  }
+
+  SwissHashMap(const SwissHashMap &other)
+  {
+    if (other.capacity == 0)
+      return;
+
+    allocate(other.capacity);
+    control = other.control;
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (!isFull(control[i]))
+        continue;
+      try
+      {
+        new (slots + i) value_type(other.slots[i]);
+      }
+      catch (...)
+      {
+        // only the slots before i were made
+        std::fill(control.begin() + i, control.end(), emptyCtrl);
+        release();
+        throw;
+      }
+    }
+    size = other.size;
+    growthLeft = other.growthLeft;
+  }
+
+  SwissHashMap(SwissHashMap &&other) noexcept
+  {
+    swap(other);
+  }
+
+  SwissHashMap &operator=(const SwissHashMap &other)
+  {
+    if (this != &other)
+    {
+      SwissHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  SwissHashMap &operator=(SwissHashMap &&other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~SwissHashMap()
+  {
+    release();
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type &operator[](const key_type &key)
+  {
+    return tryEmplace(key).first->second;
+  }
+
+  mapped_type &operator[](key_type &&key)
+  {
+    return tryEmplace(std::move(key)).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+  {
+    return tryEmplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+  {
+    return tryEmplace(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+  {
+    return insertOrAssign(key, std::forward<M>(value));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+  {
+    return insertOrAssign(std::move(key), std::forward<M>(value));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args)
+  {
+    value_type value(std::forward<Args>(args)...);
+    return tryEmplace(std::move(value.first), std::move(value.second));
+  }
+
+  const mapped_type &valueOf(const key_type &key) const
+  {
+    const_iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  mapped_type &valueOf(const key_type &key)
+  {
+    iterator it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key does not exists");
+
+    return it->second;
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    return const_iterator(this, findIndex(key, hashOf(key)));
+  }
+
+  iterator find(const key_type &key)
+  {
+    return iterator(const_iterator(this, findIndex(key, hashOf(key))));
+  }
+
+  void remove(const key_type &key)
+  {
+    auto index = findIndex(key, hashOf(key));
+    if (index == capacity)
+      throw std::out_of_range("Removing non existing key");
+
+    eraseAt(index);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    if (it == end())
+      throw std::out_of_range("Removing end iterator");
+
+    eraseAt(it.index);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const SwissHashMap &other) const
+  {
+    if (size != other.size)
+      return false;
+
+    for (auto &item : other)
+    {
+      auto it = find(item.first);
+      if (it == end() || it->second != item.second)
+        return false;
+    }
+    return true;
+  }
+
+  bool operator!=(const SwissHashMap &other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return const_iterator(this, nextFull(0));
+  }
+
+  const_iterator cend() const
+  {
+    return const_iterator(this, capacity);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+  using ctrl_type = std::int8_t;
+
+  enum : ctrl_type
+  {
+    emptyCtrl = -128, // 0b10000000
+    deletedCtrl = -2  // 0b11111110
+  };
+  enum : size_type
+  {
+    groupWidth = 16
+  };
+
+  // One probing step looks at 16 control bytes. Each match* method returns a
+  // bit mask with bit i set if control byte i satisfies the predicate.
+  class Group
+  {
+  public:
+    explicit Group(const ctrl_type *position)
+    {
+#if defined(__SSE2__)
+      ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(position));
+#else
+      std::memcpy(ctrl, position, groupWidth);
+#endif
+    }
+
+    std::uint32_t match(ctrl_type h2) const
+    {
+#if defined(__SSE2__)
+      return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+#else
+      std::uint32_t mask = 0;
+      for (size_type i = 0; i < groupWidth; ++i)
+        mask |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
+      return mask;
+#endif
+    }
+
+    std::uint32_t matchEmpty() const
+    {
+      return match(static_cast<ctrl_type>(emptyCtrl));
+    }
+
+    // empty and deleted are the only control values with the sign bit set
+    std::uint32_t matchEmptyOrDeleted() const
+    {
+#if defined(__SSE2__)
+      return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+      std::uint32_t mask = 0;
+      for (size_type i = 0; i < groupWidth; ++i)
+        mask |= static_cast<std::uint32_t>(ctrl[i] < 0) << i;
+      return mask;
+#endif
+    }
+
+  private:
+#if defined(__SSE2__)
+    __m128i ctrl;
+#else
+    ctrl_type ctrl[groupWidth];
+#endif
+  };
+
+  std::vector<ctrl_type> control;
+  value_type *slots = nullptr;
+  size_type capacity = 0;
+  size_type size = 0;
+  size_type growthLeft = 0;
+
+  static bool isFull(ctrl_type c)
+  {
+    return c >= 0;
+  }
+
+  static size_type maxLoad(size_type capacity)
+  {
+    return capacity - capacity / 8;
+  }
+
+  static std::uint64_t hashOf(const key_type &key)
+  {
+    return detail::mixHash(std::hash<key_type>{}(key));
+  }
+
+  static ctrl_type fingerprint(std::uint64_t hash)
+  {
+    return static_cast<ctrl_type>(hash & 0x7f);
+  }
+
+  size_type firstGroup(std::uint64_t hash) const
+  {
+    return static_cast<size_type>(hash >> 7) & (capacity / groupWidth - 1);
+  }
+
+  // triangular probing over a power of two number of groups visits every group
+  size_type nextGroup(size_type group, size_type step) const
+  {
+    return (group + step) & (capacity / groupWidth - 1);
+  }
+
+  size_type findIndex(const key_type &key, std::uint64_t hash) const
+  {
+    if (capacity == 0)
+      return capacity;
+
+    const auto h2 = fingerprint(hash);
+    auto group = firstGroup(hash);
+    for (size_type step = 1;; ++step)
+    {
+      Group g(control.data() + group * groupWidth);
+      for (auto mask = g.match(h2); mask != 0; mask &= mask - 1)
+      {
+        auto index = group * groupWidth + detail::countTrailingZeros(mask);
+        if (slots[index].first == key)
+          return index;
+      }
+      if (g.matchEmpty() != 0)
+        return capacity;
+      group = nextGroup(group, step);
+    }
+  }
+
+  size_type findInsertSlot(std::uint64_t hash) const
+  {
+    auto group = firstGroup(hash);
+    for (size_type step = 1;; ++step)
+    {
+      auto mask = Group(control.data() + group * groupWidth).matchEmptyOrDeleted();
+      if (mask != 0)
+        return group * groupWidth + detail::countTrailingZeros(mask);
+      group = nextGroup(group, step);
+    }
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+  {
+    const auto h = hashOf(key);
+    auto index = findIndex(key, h);
+    if (index != capacity)
+      return { iterator(const_iterator(this, index)), false };
+
+    // built before growing, as the arguments may refer to items of this map
+    value_type value(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    index = prepareInsert(h);
+    new (slots + index) value_type(std::move(value));
+    return { iterator(const_iterator(this, index)), true };
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insertOrAssign(K &&key, M &&value)
+  {
+    auto result = tryEmplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second)
+      result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  // Picks a free slot for a new key, growing the table first if needed.
+  // The slot is marked as full, the caller constructs the value in it.
+  size_type prepareInsert(std::uint64_t hash)
+  {
+    if (capacity == 0)
+      rehash(groupWidth);
+
+    auto index = findInsertSlot(hash);
+    if (growthLeft == 0 && control[index] == emptyCtrl)
+    {
+      // many tombstones: clean them up in place, otherwise grow
+      rehash(size < maxLoad(capacity) / 2 ? capacity : capacity * 2);
+      index = findInsertSlot(hash);
+    }
+
+    if (control[index] == emptyCtrl)
+      --growthLeft;
+    control[index] = fingerprint(hash);
+    ++size;
+    return index;
+  }
+
+  void eraseAt(size_type index)
+  {
+    slots[index].~value_type();
+    --size;
+
+    // Lookups stop at the first group holding an empty slot, so if this group
+    // already has one, no probe sequence continues past it and the slot can
+    // become empty again instead of a tombstone.
+    const auto group = index / groupWidth;
+    if (Group(control.data() + group * groupWidth).matchEmpty() != 0)
+    {
+      control[index] = emptyCtrl;
+      ++growthLeft;
+    }
+    else
+      control[index] = deletedCtrl;
+  }
+
+  void reserveFor(size_type count)
+  {
+    size_type newCapacity = groupWidth;
+    while (maxLoad(newCapacity) < count)
+      newCapacity *= 2;
+    if (newCapacity > capacity)
+      rehash(newCapacity);
+  }
+
+  void allocate(size_type newCapacity)
+  {
+    control.assign(newCapacity, emptyCtrl);
+    slots = std::allocator<value_type>{}.allocate(newCapacity);
+    capacity = newCapacity;
+    growthLeft = maxLoad(newCapacity);
+  }
+
+  void rehash(size_type newCapacity)
+  {
+    SwissHashMap fresh;
+    fresh.allocate(newCapacity);
+
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (!isFull(control[i]))
+        continue;
+
+      const auto hash = hashOf(slots[i].first);
+      const auto index = fresh.findInsertSlot(hash);
+      fresh.control[index] = fingerprint(hash);
+      new (fresh.slots + index) value_type(std::move(slots[i]));
+      --fresh.growthLeft;
+      ++fresh.size;
+    }
+
+    swap(fresh);
+  }
+
+  void release()
+  {
+    if (slots == nullptr)
+      return;
+
+    for (size_type i = 0; i < capacity; ++i)
+    {
+      if (isFull(control[i]))
+        slots[i].~value_type();
+    }
+    std::allocator<value_type>{}.deallocate(slots, capacity);
+    slots = nullptr;
+    control.clear();
+    capacity = size = growthLeft = 0;
+  }
+
+  void swap(SwissHashMap &other) noexcept
+  {
+    std::swap(control, other.control);
+    std::swap(slots, other.slots);
+    std::swap(capacity, other.capacity);
+    std::swap(size, other.size);
+    std::swap(growthLeft, other.growthLeft);
+  }
+
+  size_type nextFull(size_type index) const
+  {
+    while (index < capacity && !isFull(control[index]))
+      ++index;
+    return index;
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class SwissHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SwissHashMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename SwissHashMap::value_type;
+  using pointer = const typename SwissHashMap::value_type *;
+  using size_type = typename SwissHashMap::size_type;
+
+  explicit ConstIterator(const SwissHashMap *map, size_type index) : map(map), index(index)
+  {
+  }
+
+  ConstIterator(const ConstIterator &other) : map(other.map), index(other.index)
+  {
+  }
+
+  ConstIterator &operator++()
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Incrementing end iterator");
+
+    index = map->nextFull(index + 1);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    auto result = *this;
+    operator++();
+    return result;
+  }
+
+  ConstIterator &operator--()
+  {
+    auto previous = index;
+    while (previous > 0)
+    {
+      if (isFull(map->control[--previous]))
+      {
+        index = previous;
+        return *this;
+      }
+    }
+    throw std::out_of_range("Decrementing begin iterator");
+  }
+
+  ConstIterator operator--(int)
+  {
+    auto result = *this;
+    operator--();
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if (index >= map->capacity)
+      throw std::out_of_range("Dereferencing end iterator");
+    return map->slots[index];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator &other) const
+  {
+    return index == other.index;
+  }
+
+  bool operator!=(const ConstIterator &other) const
+  {
+    return !(*this == other);
+  }
+
+  const SwissHashMap *map;
+  size_type index;
+};
+
+template <typename KeyType, typename ValueType>
+class SwissHashMap<KeyType, ValueType>::Iterator : public SwissHashMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename SwissHashMap::reference;
+  using pointer = typename SwissHashMap::value_type *;
+
+  Iterator(const ConstIterator &other)
+      : ConstIterator(other)
+  {
+  }
+
+  Iterator &operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator &operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_SWISSHASHMAP_H */
@@ -2,26 +2,33 @@
 #define AISDI_MAPS_TREEMAP_H
 
 #include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <type_traits>
+
+#include "MapTraits.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
 class TreeMap
 {
     struct Node
     {
         using key_type = KeyType;
         using mapped_type = ValueType;
-        using value_type = std::pair<key_type, mapped_type>;
+        using value_type = typename detail::StoredValue<key_type, mapped_type>::type;
         using size_type = std::size_t;
 
-        Node(key_type key, mapped_type value) : pair(key, value) {}
+        explicit Node(value_type pair) : pair(std::move(pair)) {}
+        template <typename... Args>
+        explicit Node(std::piecewise_construct_t, Args &&... args) : pair(std::piecewise_construct, std::forward<Args>(args)...) {}
         /*Node(const Node& other) : pair(other.pair.first, other.pair.second), height(other.height)
         {
             if(other.leftChild){
@@ -57,12 +64,12 @@ class TreeMap
             delete rightChild;
         }
 
-        void insert(Node *node)
+        void insert(Node *node, const Compare &less)
         {
             auto current = this;
-            while (current->pair.first != node->pair.first)
+            while (true)
             {
-                if (node->pair.first < current->pair.first)
+                if (less(node->key(), current->key()))
                 {
                     if (current->hasLeftChild())
                         current = current->leftChild;
@@ -73,7 +80,7 @@ class TreeMap
                     }
                 }
 
-                else if (node->pair.first > current->pair.first)
+                else if (less(current->key(), node->key()))
                 {
                     if (current->hasRightChild())
                         current = current->rightChild;
@@ -83,6 +90,8 @@ class TreeMap
                         break;
                     }
                 }
+                else
+                    break;
             }
         }
 
@@ -114,12 +123,13 @@ class TreeMap
             return this;
         }
 
-        Node *find(key_type key)
+        template <typename K>
+        Node *find(const K &key, const Compare &less)
         {
             auto current = this;
-            while (current->pair.first != key)
+            while (true)
             {
-                if (key < current->pair.first)
+                if (less(key, current->key()))
                 {
                     if (current->hasLeftChild())
                         current = current->leftChild;
@@ -127,16 +137,16 @@ class TreeMap
                         return nullptr;
                 }
 
-                else if (key > current->pair.first)
+                else if (less(current->key(), key))
                 {
                     if (current->hasRightChild())
                         current = current->rightChild;
                     else
                         return nullptr;
                 }
+                else
+                    return current;
             }
-
-            return current;
         }
         Node *succesor() const
         {
@@ -170,7 +180,7 @@ class TreeMap
         {
             size_t left = leftChild ? leftChild->height : 0;
             size_t right = rightChild ? rightChild->height : 0;
-            height = 1 + std::max(left, right);
+            height = static_cast<std::uint32_t>(1 + std::max(left, right));
         }
         
         Node* min()
@@ -183,18 +193,21 @@ class TreeMap
         Node* max()
         {
             if(hasRightChild())
-                return rightChild->min();
+                return rightChild->max();
             return this;
         }
 
+        const key_type &key() const { return detail::StoredValue<key_type, mapped_type>::keyOf(pair); }
+
         bool hasLeftChild() const { return leftChild != nullptr; }
         bool hasRightChild() const { return rightChild != nullptr; }
 
         value_type pair;
+        // right after the pair, so that a 4-byte key (TreeSet) and the height share 8 bytes
+        std::uint32_t height = 0;
         Node *leftChild = nullptr;
         Node *rightChild = nullptr;
         Node *parent = nullptr;
-        size_type height = 0;
 
       private:
         void makeRightChildOf(Node *node)
@@ -225,11 +238,12 @@ class TreeMap
       public:
         using key_type = KeyType;
         using mapped_type = ValueType;
-        using value_type = std::pair<key_type, mapped_type>;
+        using value_type = typename detail::StoredValue<key_type, mapped_type>::type;
         using size_type = std::size_t;
 
         AVLTree() : root(nullptr) {}
-        AVLTree(const AVLTree &other)
+        explicit AVLTree(const Compare &compare) : root(nullptr), compare(compare) {}
+        AVLTree(const AVLTree &other) : compare(other.compare)
         {
             if (!other.root)
                 return;
@@ -244,7 +258,7 @@ class TreeMap
             }
 
         }
-        AVLTree(AVLTree &&other) : root(nullptr) { std::swap(root, other.root); }
+        AVLTree(AVLTree &&other) : root(nullptr), compare(other.compare) { std::swap(root, other.root); }
         AVLTree &operator=(const AVLTree &other)
         {
             if(this == &other)
@@ -252,6 +266,7 @@ class TreeMap
 
             delete root;
             root = nullptr;
+            compare = other.compare;
 
             Node *n = other.minNode();
             while (n != nullptr)
@@ -266,20 +281,58 @@ class TreeMap
             delete root;
             root = nullptr;
             std::swap(root, other.root);
+            compare = other.compare;
             return *this;
         }
 
         Node *insert(const value_type &pair)
         {
-            return insert(pair.first, pair.second);
+            return insertNode(new Node(pair));
         }
 
         Node *insert(const key_type &key, const mapped_type &value)
         {
-            auto newNode = new Node(key, value);
+            return insertNode(new Node(detail::StoredValue<key_type, mapped_type>::make(key, value)));
+        }
+
+        // Builds the pair right in the new node, from key and mapped_type(args...).
+        template <typename K, typename... Args>
+        Node *emplace(K &&key, Args &&... args)
+        {
+            return emplaceNode(std::is_same<mapped_type, detail::NoValue>(), std::forward<K>(key),
+                               std::forward<Args>(args)...);
+        }
+
+        template <typename K, typename... Args>
+        Node *emplaceNode(std::false_type, K &&key, Args &&... args)
+        {
+            return insertNode(new Node(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                                       std::forward_as_tuple(std::forward<Args>(args)...)));
+        }
+
+        // sets keep the key alone
+        template <typename K>
+        Node *emplaceNode(std::true_type, K &&key)
+        {
+            return insertNode(new Node(value_type(std::forward<K>(key))));
+        }
+
+        // Replaces the whole tree with count items taken from first, which
+        // have to be sorted and unique. Builds a perfectly balanced tree in
+        // linear time, where inserting one by one would take n log n.
+        template <typename InputIt>
+        void assignSorted(InputIt first, size_type count)
+        {
+            auto built = buildSorted(first, count, nullptr);
+            delete root;
+            root = built;
+        }
+
+        Node *insertNode(Node *newNode)
+        {
             if (root != nullptr)
             {
-                root->insert(newNode);
+                root->insert(newNode, compare);
                 rebalance(newNode);
             }
             else
@@ -288,12 +341,13 @@ class TreeMap
             return newNode;
         }
 
-        void remove(key_type key)
+        template <typename K>
+        void remove(const K &key)
         {
             if (root == nullptr)
                 throw std::out_of_range("Removing non existing element from tree");
 
-            auto nodeToRemove = root->find(key);
+            auto nodeToRemove = root->find(key, compare);
             if (nodeToRemove == nullptr)
                 throw std::out_of_range("Removing non existing element from tree");
 
@@ -314,12 +368,13 @@ class TreeMap
             delete nodeToRemove;
         }
 
-        Node *findNode(key_type key) const
+        template <typename K>
+        Node *findNode(const K &key) const
         {
             if (root == nullptr)
                 return nullptr;
 
-            return root->find(key);
+            return root->find(key, compare);
              
         }
 
@@ -334,23 +389,25 @@ class TreeMap
             return root ? root->max() : root;
         }
 
-        mapped_type &get(key_type key) const
+        template <typename K>
+        mapped_type &get(const K &key) const
         {
             if (root == nullptr)
                 throw std::out_of_range("No such key in the tree");
 
-            Node *node = root->find(key);
+            Node *node = root->find(key, compare);
             if (node == nullptr)
                 throw std::out_of_range("No such key in the tree");
 
             return node->pair.second;
         }
 
-        bool keyExists(key_type key) const
+        template <typename K>
+        bool keyExists(const K &key) const
         {
             if (root == nullptr)
                 return false;
-            return root->find(key) ? true : false;
+            return root->find(key, compare) ? true : false;
         }
 
         bool isEmpty() const { return root == nullptr; }
@@ -359,6 +416,7 @@ class TreeMap
 
       private:
         Node *root = nullptr;
+        Compare compare = Compare();
       //  void copy
 
         void rebalance(Node *insertedNode)
@@ -391,6 +449,25 @@ class TreeMap
 
         static size_t height(Node *node) { return node ? node->height : 0; }
 
+        template <typename InputIt>
+        static Node *buildSorted(InputIt &first, size_type count, Node *parent)
+        {
+            if (count == 0)
+                return nullptr;
+
+            const auto leftCount = count / 2;
+            auto left = buildSorted(first, leftCount, nullptr);
+            auto node = new Node(*first);
+            ++first;
+            node->parent = parent;
+            node->leftChild = left;
+            if (left != nullptr)
+                left->parent = node;
+            node->rightChild = buildSorted(first, count - leftCount - 1, node);
+            node->updateHeight();
+            return node;
+        }
+
         void rightRotate(Node *node)
         {
 
@@ -452,11 +529,13 @@ class TreeMap
   public:
     using key_type = KeyType;
     using mapped_type = ValueType;
-    using value_type = std::pair<key_type, mapped_type>;
+    using value_type = typename detail::StoredValue<key_type, mapped_type>::type;
     using size_type = std::size_t;
     using reference = value_type &;
     using const_reference = const value_type &;
 
+    using key_compare = Compare;
+
     using tree_type = AVLTree;
     using tree_node = Node *;
 
@@ -465,7 +544,14 @@ class TreeMap
     using iterator = Iterator;
     using const_iterator = ConstIterator;
 
+  private:
+    template <typename K>
+    using EnableIfTransparent = typename std::enable_if<detail::IsTransparent<Compare>::value &&
+                                                        !std::is_convertible<K, const_iterator>::value>::type;
+
+  public:
     TreeMap() = default;
+    explicit TreeMap(const Compare &compare) : tree(compare) {}
     TreeMap(std::initializer_list<value_type> list) : size(list.size())
     {
         for (auto &item : list)
@@ -483,6 +569,19 @@ class TreeMap
         return tree.insert(key, ValueType{})->pair.second;
     }
 
+    // Inserts mapped_type(args...) unless the key is already there.
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args)
+    {
+        return tryEmplace(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args)
+    {
+        return tryEmplace(std::move(key), std::forward<Args>(args)...);
+    }
+
     const mapped_type &valueOf(const key_type &key) const
     {
         return tree.get(key);
@@ -515,12 +614,53 @@ class TreeMap
         if (node == nullptr)
             throw std::out_of_range("Removing end iterator");
 
-        tree.remove(node->pair.first);
+        tree.remove(node->key());
+        --size;
+    }
+
+    // Heterogeneous lookup, available when Compare is transparent (e.g. std::less<>).
+    template <typename K, typename = EnableIfTransparent<K>>
+    const mapped_type &valueOf(const K &key) const
+    {
+        return tree.get(key);
+    }
+
+    template <typename K, typename = EnableIfTransparent<K>>
+    mapped_type &valueOf(const K &key)
+    {
+        return tree.get(key);
+    }
+
+    template <typename K, typename = EnableIfTransparent<K>>
+    const_iterator find(const K &key) const
+    {
+        return iteratorOfKey(key);
+    }
+
+    template <typename K, typename = EnableIfTransparent<K>>
+    iterator find(const K &key)
+    {
+        return iterator(iteratorOfKey(key));
+    }
+
+    template <typename K, typename = EnableIfTransparent<K>>
+    void remove(const K &key)
+    {
+        tree.remove(key);
         --size;
     }
 
     size_type getSize() const { return size; }
 
+    // Replaces the content with count items read from first, which have to be
+    // sorted by key and unique. Linear time, unlike inserting them one by one.
+    template <typename InputIt>
+    void assignSorted(InputIt first, size_type count)
+    {
+        tree.assignSorted(first, count);
+        size = count;
+    }
+
     bool operator==(const TreeMap &other) const // expensive
     {
         auto iter = begin();
@@ -556,25 +696,37 @@ class TreeMap
     tree_type tree = tree_type();
     size_type size = 0;
 
-    const_iterator iteratorOfKey(const key_type &key) const
+    template <typename K>
+    const_iterator iteratorOfKey(const K &key) const
     {
         if (auto node = tree.findNode(key))
             return const_iterator(node, tree);
 
         return cend();
     }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> tryEmplace(K &&key, Args &&... args)
+    {
+        if (auto node = tree.findNode(key))
+            return { iterator(node, tree), false };
+
+        ++size;
+        return { iterator(tree.emplace(std::forward<K>(key), std::forward<Args>(args)...), tree), true };
+    }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare>
+class TreeMap<KeyType, ValueType, Compare>::ConstIterator
 {
   public:
     using reference = typename TreeMap::const_reference;
     using iterator_category = std::bidirectional_iterator_tag;
     using value_type = typename TreeMap::value_type;
+    using difference_type = std::ptrdiff_t;
     using pointer = const typename TreeMap::value_type *;
     using tree_type = typename TreeMap::tree_type;
-    using tree_node = typename TreeMap<KeyType, ValueType>::tree_node;
+    using tree_node = typename TreeMap::tree_node;
 
     explicit ConstIterator(tree_node elem, const tree_type &tree)
         : elem(elem), tree(tree) {}
@@ -646,14 +798,14 @@ class TreeMap<KeyType, ValueType>::ConstIterator
     const tree_type &tree;
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator
-    : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare>
+class TreeMap<KeyType, ValueType, Compare>::Iterator
+    : public TreeMap<KeyType, ValueType, Compare>::ConstIterator
 {
   public:
     using reference = typename TreeMap::reference;
     using pointer = typename TreeMap::value_type *;
-    using tree_node = typename TreeMap<KeyType, ValueType>::Node *;
+    using tree_node = typename TreeMap::Node *;
 
     explicit Iterator(tree_node elem, tree_type &tree)
         : ConstIterator(elem, tree) {}
@@ -0,0 +1,185 @@
+#ifndef AISDI_MAPS_TREESET_H
+#define AISDI_MAPS_TREESET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "TreeMap.h"
+
+namespace aisdi
+{
+
+// Sorted set of keys on the TreeMap engine. The nodes hold the key alone,
+// without the mapped value that TreeMap<K, char> would carry.
+template <typename KeyType, typename Compare = std::less<KeyType>>
+class TreeSet
+{
+public:
+  using map_type = TreeMap<KeyType, detail::NoValue, Compare>;
+  using key_type = KeyType;
+  using value_type = KeyType;
+  using size_type = std::size_t;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using key_compare = Compare;
+
+  // keys cannot be changed in place, both iterators are constant
+  using const_iterator = typename map_type::const_iterator;
+  using iterator = const_iterator;
+
+  TreeSet() = default;
+
+  TreeSet(std::initializer_list<value_type> list)
+  {
+    insert(list.begin(), list.end());
+  }
+
+  template <typename InputIt>
+  TreeSet(InputIt first, InputIt last)
+  {
+    insert(first, last);
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+  size_type getSize() const
+  {
+    return map.getSize();
+  }
+
+  // Returns the key's position and whether it was inserted.
+  std::pair<const_iterator, bool> insert(const key_type &key)
+  {
+    auto result = map.try_emplace(key);
+    return { result.first, result.second };
+  }
+
+  // Sorts the new keys and merges them with the set, then rebuilds the tree
+  // in one pass: n + k log k for k new keys, against k log n when inserting
+  // one by one. Worth it for big ranges, not for a few keys into a big set.
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    std::vector<key_type> keys(first, last);
+    std::sort(keys.begin(), keys.end(), Compare());
+    keys.erase(std::unique(keys.begin(), keys.end(), [](const key_type &a, const key_type &b) {
+                 return !Compare()(a, b) && !Compare()(b, a);
+               }),
+               keys.end());
+
+    std::vector<key_type> merged;
+    merged.reserve(getSize() + keys.size());
+    std::set_union(begin(), end(), std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()),
+                   std::back_inserter(merged), Compare());
+    assign(merged);
+  }
+
+  bool contains(const key_type &key) const
+  {
+    return map.find(key) != map.end();
+  }
+
+  const_iterator find(const key_type &key) const
+  {
+    return map.find(key);
+  }
+
+  void remove(const key_type &key)
+  {
+    map.remove(key);
+  }
+
+  void remove(const const_iterator &it)
+  {
+    map.remove(it);
+  }
+
+  bool operator==(const TreeSet &other) const
+  {
+    return getSize() == other.getSize() && std::equal(begin(), end(), other.begin(), [](const key_type &a, const key_type &b) {
+             return !Compare()(a, b) && !Compare()(b, a);
+           });
+  }
+
+  bool operator!=(const TreeSet &other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator begin() const
+  {
+    return map.cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return map.cend();
+  }
+
+  const_iterator cbegin() const
+  {
+    return map.cbegin();
+  }
+
+  const_iterator cend() const
+  {
+    return map.cend();
+  }
+
+  // Set operations. Each walks both sets in order once and builds the
+  // result tree straight from the sorted output, in linear time.
+
+  friend TreeSet unionOf(const TreeSet &first, const TreeSet &second)
+  {
+    std::vector<key_type> keys;
+    keys.reserve(first.getSize() + second.getSize());
+    std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(keys), Compare());
+    return fromSorted(keys);
+  }
+
+  friend TreeSet intersectionOf(const TreeSet &first, const TreeSet &second)
+  {
+    std::vector<key_type> keys;
+    keys.reserve(std::min(first.getSize(), second.getSize()));
+    std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(keys),
+                          Compare());
+    return fromSorted(keys);
+  }
+
+  // Keys of first that are not in second.
+  friend TreeSet differenceOf(const TreeSet &first, const TreeSet &second)
+  {
+    std::vector<key_type> keys;
+    keys.reserve(first.getSize());
+    std::set_difference(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(keys),
+                        Compare());
+    return fromSorted(keys);
+  }
+
+private:
+  map_type map;
+
+  void assign(std::vector<key_type> &keys)
+  {
+    map.assignSorted(std::make_move_iterator(keys.begin()), keys.size());
+  }
+
+  static TreeSet fromSorted(std::vector<key_type> &keys)
+  {
+    TreeSet result;
+    result.assign(keys);
+    return result;
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_TREESET_H */
@@ -1,4 +1,5 @@
 #include <cstddef>
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 #include <chrono>
@@ -6,9 +7,32 @@
 #include <cstdlib>
 #include <ctime>
 #include <initializer_list>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 #include "TreeMap.h"
 #include "HashMap.h"
+#include "SwissHashMap.h"
+#include "RobinHoodHashMap.h"
+#include "DenseHashMap.h"
+#include "ConcurrentHashMap.h"
+#include "LockFreeHashMap.h"
+#include "SnapshotHashMap.h"
+#include "SmallMap.h"
+#include "MappedHashMap.h"
+#include "FrozenHashMap.h"
+#include "ConstexprMap.h"
+#include "StringHashMap.h"
+#include "HashSet.h"
+#include "TreeSet.h"
 
 template <typename Func, typename Map>
 void doAction(std::size_t count, Map &&map, Func action)
@@ -29,68 +53,933 @@ auto measureTime(Func f)
   return std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 }
 
-template <typename Func>
-auto measureTreeTime(std::size_t count, Func f)
+template <typename Map>
+void benchmarkMap(const std::string &name, std::size_t count)
 {
-  return measureTime([&] {
-    doAction(count, aisdi::TreeMap<int, int>{}, f);
+  Map filled;
+  for (size_t i = 0; i < count; i++)
+    filled[i] = i;
+
+  auto append = measureTime([&] {
+    doAction(count, Map{}, [](Map &map, int) {
+      map[std::rand()] = std::rand();
+    }); });
+  auto remove = measureTime([&] {
+    doAction(count, Map{filled}, [](Map &map, int i) {
+      map.remove(i);
+    }); });
+  auto find = measureTime([&] {
+    doAction(count, Map{filled}, [](Map &map, int i) {
+      map.find(i);
+    }); });
+
+  std::cout << "Appending " << count << " elements to " << name << " took: " << append.count() << " miliseconds" << std::endl;
+  std::cout << "Removing " << count << " elements from " << name << " took: " << remove.count() << " miliseconds" << std::endl;
+  std::cout << "Finding " << count << " elements from " << name << " took: " << find.count() << " miliseconds" << std::endl;
+}
+
+// Keeps the map at a constant size while replacing entries (remove + insert)
+// and reports the latency distribution of lookups made in between.
+template <typename Map>
+void benchmarkChurn(const std::string &name, std::size_t count)
+{
+  Map map;
+  for (size_t i = 0; i < count; i++)
+    map[i] = i;
+
+  std::vector<long long> latencies;
+  latencies.reserve(count);
+  std::size_t oldest = 0, next = count;
+  for (size_t i = 0; i < count; i++)
+  {
+    map.remove(oldest++);
+    map[next++] = i;
+
+    int key = oldest + std::rand() % count;
+    auto start = std::chrono::steady_clock::now();
+    map.find(key);
+    auto end = std::chrono::steady_clock::now();
+    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "Lookups under churn in " << name << ": p50 " << latencies[latencies.size() / 2]
+            << " ns, p99 " << latencies[latencies.size() * 99 / 100]
+            << " ns, max " << latencies.back() << " ns" << std::endl;
+}
+
+// Long string keys make hashing expensive, which is what StoreHash saves on resize.
+template <typename Map>
+void benchmarkStringKeys(const std::string &name, std::size_t count)
+{
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; i++)
+    keys.push_back(std::string(48, 'k') + std::to_string(i));
+
+  auto append = measureTime([&] {
+    Map map;
+    for (size_t i = 0; i < count; i++)
+      map[keys[i]] = i;
   });
+
+  std::cout << "Appending " << count << " string keys to " << name << " took: " << append.count() << " miliseconds" << std::endl;
 }
 
-template <typename Func>
-auto measureHashTime(std::size_t count, Func f)
+// Records the slowest single insert, which is where a stop-the-world rehash shows up.
+void benchmarkInsertLatency(const std::string &name, std::size_t count, aisdi::RehashMode mode)
+{
+  aisdi::HashMap<int, int> map;
+  map.setRehashMode(mode);
+
+  long long slowest = 0, total = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    map[i] = i;
+    auto end = std::chrono::steady_clock::now();
+    long long latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    slowest = std::max(slowest, latency);
+    total += latency;
+  }
+
+  std::cout << "Inserting " << count << " elements to " << name << ": mean " << total / std::max<long long>(count, 1)
+            << " ns, max " << slowest << " ns per insert" << std::endl;
+}
+
+// Heap bytes in use, including allocator bookkeeping. 0 where it cannot be measured.
+std::size_t heapInUse()
 {
-  return measureTime([&] {
-    doAction(count, aisdi::HashMap<int, int>{}, f);
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  auto info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+// Memory taken by a map of count entries and the time it took to fill it.
+// Has to run before anything else uses the same pool, which keeps its slabs.
+template <typename Map>
+void benchmarkMemory(const std::string &name, std::size_t count)
+{
+  const auto before = heapInUse();
+  Map map;
+  auto append = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      map[i] = i;
   });
+  const auto after = heapInUse();
+
+  std::cout << "Filling " << name << " with " << count << " elements took: " << append.count() << " miliseconds, "
+            << (after - before) / std::max<std::size_t>(count, 1) << " bytes per element" << std::endl;
 }
 
-int main(int argc, char **argv)
+// Same for a set, to compare with the maps of bool it replaces.
+template <typename Set>
+void benchmarkSetMemory(const std::string &name, std::size_t count)
 {
-  std::srand(std::time(nullptr)); // use current time as seed for random generator
-  const std::size_t count = argc > 1 ? std::atoll(argv[1]) : 10000;
+  const auto before = heapInUse();
+  Set set;
+  auto append = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      set.insert(i);
+  });
+  const auto after = heapInUse();
 
-  aisdi::HashMap<int, int> hm;
-  aisdi::TreeMap<int, int> tm;
+  std::cout << "Filling " << name << " with " << count << " elements took: " << append.count() << " miliseconds, "
+            << (after - before) / std::max<std::size_t>(count, 1) << " bytes per element" << std::endl;
+}
 
+// Union, intersection and difference of two half-overlapping sets of count keys.
+template <typename Set>
+void benchmarkSetOperations(const std::string &name, std::size_t count)
+{
+  std::vector<int> firstKeys, secondKeys;
   for (size_t i = 0; i < count; i++)
   {
-    hm[i] = i;
-    tm[i] = i;
+    firstKeys.push_back(i);
+    secondKeys.push_back(i + count / 2);
   }
+  Set first(firstKeys.begin(), firstKeys.end()), second(secondKeys.begin(), secondKeys.end());
+
+  std::size_t sizes = 0;
+  auto time = measureTime([&] {
+    sizes += unionOf(first, second).getSize();
+    sizes += intersectionOf(first, second).getSize();
+    sizes += differenceOf(first, second).getSize();
+  });
+
+  std::cout << "Union, intersection and difference of two " << name << "s of " << count
+            << " elements took: " << time.count() << " miliseconds (" << sizes << " keys)" << std::endl;
+}
+
+// Bulk load of sequential keys, with and without presizing the table.
+void benchmarkBulkLoad(const std::string &name, std::size_t count, bool reserve)
+{
+  auto append = measureTime([&] {
+    aisdi::HashMap<int, int> map;
+    if (reserve)
+      map.reserve(count);
+    for (size_t i = 0; i < count; i++)
+      map[i] = i;
+  });
+
+  std::cout << "Loading " << count << " elements to " << name << " took: " << append.count() << " miliseconds" << std::endl;
+}
 
-  
-  auto treeAppend = measureTreeTime(count, [&](aisdi::TreeMap<int, int>& map, int) {
-    map[std::rand()] = std::rand();
+// Full scans of a table that kept its size after 99% of the items were
+// removed, plus repeated begin() on it.
+template <typename Map>
+void benchmarkSparseIteration(const std::string &name, std::size_t count)
+{
+  Map map;
+  for (size_t i = 0; i < count; i++)
+    map[i] = i;
+  for (size_t i = 0; i < count; i++)
+    if (i % 100 != 0)
+      map.remove(i);
+
+  long long sum = 0;
+  auto scans = measureTime([&] {
+    long long local = 0; // a captured accumulator would go through memory
+    for (int round = 0; round < 100; ++round)
+      for (auto &item : map)
+        local += item.second;
+    sum = local;
   });
-  auto hashAppend = measureHashTime(count, [&](aisdi::HashMap<int, int>& map, int) {
-    map[std::rand()] = std::rand();
+  auto begins = measureTime([&] {
+    for (int round = 0; round < 100000; ++round)
+      sum += map.begin()->second;
+  });
+
+  std::cout << "100 scans of sparse " << name << " took: " << scans.count() << " miliseconds, 100000 begin() calls: "
+            << begins.count() << " miliseconds (checksum " << sum % 10 << ")" << std::endl;
+}
+
+// 100 full scans of a map filled with random keys, the workload DenseHashMap
+// is for; benchmarkVectorScan() gives the bound it should reach.
+template <typename Map>
+void benchmarkScan(const std::string &name, std::size_t count)
+{
+  Map map;
+  for (size_t i = 0; i < count; i++)
+    map[std::rand()] = i;
+
+  long long sum = 0;
+  auto scans = measureTime([&] {
+    long long local = 0; // a captured accumulator would go through memory
+    for (int round = 0; round < 100; ++round)
+      for (auto &item : map)
+        local += item.second;
+    sum = local;
   });
 
-  auto hashRemove = measureTime([&] { 
-      doAction(count, aisdi::HashMap<int, int>{hm}, [](aisdi::HashMap<int, int> &map, int i) {
-        map.remove(i);
-      }); });
-  auto treeRemove = measureTime([&] { 
-      doAction(count, aisdi::TreeMap<int, int>{tm}, [](aisdi::TreeMap<int, int> &map, int i) {
-        map.remove(i);
-      }); });
-  
-  auto hashFind = measureTime([&] {
-      doAction(count, aisdi::HashMap<int, int>{hm}, [](aisdi::HashMap<int, int> &map, int i) {
-        map.find(i);
-       }); });
-  auto treeFind = measureTime([&] { 
-      doAction(count, aisdi::TreeMap<int, int>{tm}, [](aisdi::TreeMap<int, int> &map, int i) {
-        map.find(i);
-       }); });
+  std::cout << "100 scans of " << name << " took: " << scans.count() << " miliseconds (checksum " << sum % 10 << ")"
+            << std::endl;
+}
+
+void benchmarkVectorScan(std::size_t count)
+{
+  std::vector<std::pair<int, int>> items;
+  for (size_t i = 0; i < count; i++)
+    items.emplace_back(std::rand(), i);
+
+  long long sum = 0;
+  auto scans = measureTime([&] {
+    long long local = 0;
+    for (int round = 0; round < 100; ++round)
+      for (auto &item : items)
+        local += item.second;
+    sum = local;
+  });
+
+  std::cout << "100 scans of std::vector took: " << scans.count() << " miliseconds (checksum " << sum % 10 << ")"
+            << std::endl;
+}
+
+// Builds, fills and queries `count` short-lived maps of `size` items each, the
+// workload SmallMap keeps off the heap.
+template <typename Map>
+void benchmarkSmallMaps(const std::string &name, std::size_t count)
+{
+  long long sum = 0;
+  std::cout << "Building and searching " << count << " " << name << "s of n items took:";
+  for (std::size_t size = 1; size <= 64; size *= 2)
+  {
+    auto time = measureTime([&] {
+      long long local = 0;
+      for (size_t i = 0; i < count; i++)
+      {
+        Map map;
+        for (size_t key = 0; key < size; key++)
+          map[(key * 7 + i) % 64] = key;
+        for (size_t key = 0; key < size; key++)
+          local += map.find(key) != map.end();
+      }
+      sum += local;
+    });
+    std::cout << " n=" << size << " " << time.count() << " ms";
+  }
+  std::cout << " (checksum " << sum % 10 << ")" << std::endl;
+}
+
+// Random lookups, one find() at a time versus findMany() over batches of keys.
+// Meant for tables that do not fit in the last-level cache, see main().
+template <typename Map>
+void benchmarkBatchLookup(const std::string &name, std::size_t count)
+{
+  Map map;
+  map.reserve(count);
+  for (size_t i = 0; i < count; i++)
+    map[i] = i;
+
+  std::vector<int> keys(count);
+  for (auto &key : keys)
+    key = static_cast<int>((static_cast<std::size_t>(std::rand()) * RAND_MAX + std::rand()) % (2 * count));
+
+  std::size_t foundScalar = 0, foundBatch = 0;
+  auto scalar = measureTime([&] {
+    for (auto key : keys)
+      foundScalar += map.find(key) != map.end();
+  });
+
+  const std::size_t batchSize = 256;
+  std::vector<typename Map::iterator> found(batchSize);
+  auto batch = measureTime([&] {
+    for (std::size_t i = 0; i < keys.size(); i += batchSize)
+    {
+      auto last = keys.begin() + std::min(i + batchSize, keys.size());
+      auto end = map.findMany(keys.begin() + i, last, found.begin());
+      for (auto it = found.begin(); it != end; ++it)
+        foundBatch += *it != map.end();
+    }
+  });
+
+  std::cout << "Looking up " << count << " random keys in " << name << " took: " << scalar.count()
+            << " miliseconds one by one, " << batch.count() << " miliseconds in batches (found "
+            << foundScalar << " / " << foundBatch << ")" << std::endl;
+}
+
+// Lookups of which missRatio percent miss, with and without the Bloom filter.
+void benchmarkMisses(std::size_t count, int missRatio, bool bloomFilter)
+{
+  aisdi::HashMap<int, int> map;
+  map.setBloomFilter(bloomFilter);
+  for (size_t i = 0; i < count; i++)
+    map[i * 2] = i;
+
+  std::vector<int> keys(count);
+  for (auto &key : keys)
+  {
+    auto index = static_cast<int>((static_cast<std::size_t>(std::rand()) * RAND_MAX + std::rand()) % count);
+    key = index * 2 + (std::rand() % 100 < missRatio ? 1 : 0);
+  }
+
+  std::size_t found = 0;
+  auto time = measureTime([&] {
+    for (auto key : keys)
+      found += map.find(key) != map.end();
+  });
+
+  std::cout << "Looking up " << count << " keys (" << missRatio << "% missing) in HashMap"
+            << (bloomFilter ? " with Bloom filter" : "") << " took: " << time.count() << " miliseconds (found "
+            << found << ")" << std::endl;
+}
+
+// The baseline ConcurrentHashMap replaces: a single HashMap behind one mutex.
+class LockedHashMap
+{
+public:
+  void upsert(int key, int value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    map[key] = value;
+  }
+
+  bool contains(int key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map.find(key) != map.end();
+  }
+
+  bool insert(int key, int value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map.try_emplace(key, value).second;
+  }
+
+  bool remove(int key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = map.find(key);
+    if (it == map.end())
+      return false;
+    map.remove(it);
+    return true;
+  }
+
+private:
+  std::mutex mutex;
+  aisdi::HashMap<int, int> map;
+};
+
+// Every thread runs count operations on keys below count, 9 lookups for each
+// upsert. Reports millions of operations per second for 1 to 64 threads.
+template <typename Map>
+void benchmarkConcurrent(const std::string &name, std::size_t count)
+{
+  for (std::size_t threadsCount = 1; threadsCount <= 64; threadsCount *= 2)
+  {
+    Map map;
+    for (size_t i = 0; i < count; i++)
+      map.upsert(i, i);
+
+    std::atomic<std::size_t> hits(0);
+    auto elapsed = measureTime([&] {
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t < threadsCount; ++t)
+        threads.emplace_back([&map, &hits, count, t] {
+          std::size_t state = t + 1, found = 0;
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            int key = static_cast<int>((state >> 33) % count);
+            if (i % 10 == 0)
+              map.upsert(key, static_cast<int>(i));
+            else
+              found += map.contains(key);
+          }
+          hits += found;
+        });
+      for (auto &thread : threads)
+        thread.join();
+    });
+
+    const double operations = static_cast<double>(count) * threadsCount;
+    std::cout << name << " with " << threadsCount << " threads: "
+              << operations / std::max<long long>(elapsed.count(), 1) / 1000 << " Mops/s" << std::endl;
+  }
+}
+
+// Every thread runs count operations on keys below 2 * count: 8 lookups, one
+// insert and one remove in every 10. Reports throughput and the latency
+// distribution of single operations for 1 to 64 threads.
+template <typename Map>
+void benchmarkMixedLatency(const std::string &name, std::size_t count)
+{
+  for (std::size_t threadsCount = 1; threadsCount <= 64; threadsCount *= 2)
+  {
+    Map map;
+    for (size_t i = 0; i < count; i++)
+      map.insert(2 * i, i);
+
+    std::vector<std::vector<long long>> latencies(threadsCount);
+    auto elapsed = measureTime([&] {
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t < threadsCount; ++t)
+        threads.emplace_back([&map, &latencies, count, t] {
+          auto &samples = latencies[t];
+          samples.reserve(count);
+          std::size_t state = t + 1;
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            int key = static_cast<int>((state >> 33) % (2 * count));
+            auto start = std::chrono::steady_clock::now();
+            if (i % 10 == 0)
+              map.insert(key, static_cast<int>(i));
+            else if (i % 10 == 1)
+              map.remove(key);
+            else
+              map.contains(key);
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+          }
+        });
+      for (auto &thread : threads)
+        thread.join();
+    });
+
+    std::vector<long long> all;
+    for (auto &samples : latencies)
+      all.insert(all.end(), samples.begin(), samples.end());
+    std::sort(all.begin(), all.end());
+
+    const double operations = static_cast<double>(count) * threadsCount;
+    std::cout << name << " with " << threadsCount << " threads: "
+              << operations / std::max<long long>(elapsed.count(), 1) / 1000 << " Mops/s, p50 "
+              << all[all.size() / 2] << " ns, p99 " << all[all.size() * 99 / 100] << " ns, p99.9 "
+              << all[all.size() * 999 / 1000] << " ns, max " << all.back() << " ns" << std::endl;
+  }
+}
+
+template <typename Map>
+void fillForReading(Map &map, std::size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+    map.upsert(i, i);
+}
+
+// Every upsert copies a snapshot, so build the table once.
+void fillForReading(aisdi::SnapshotHashMap<int, int> &map, std::size_t count)
+{
+  aisdi::SnapshotHashMap<int, int>::map_type table;
+  table.reserve(count);
+  for (size_t i = 0; i < count; i++)
+    table[i] = i;
+  map.publish(std::move(table));
+}
+
+// Reader threads run count lookups each while one more thread changes a key
+// every 100 ms. Reports millions of lookups per second for 1 to 64 readers.
+template <typename Map>
+void benchmarkReadMostly(const std::string &name, std::size_t count)
+{
+  for (std::size_t threadsCount = 1; threadsCount <= 64; threadsCount *= 2)
+  {
+    Map map;
+    fillForReading(map, count);
+
+    std::atomic<bool> done(false);
+    std::thread writer([&map, &done, count] {
+      for (std::size_t i = 0; !done; ++i)
+      {
+        map.upsert(static_cast<int>(i % count), static_cast<int>(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    });
+
+    std::atomic<std::size_t> hits(0);
+    auto elapsed = measureTime([&] {
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t < threadsCount; ++t)
+        threads.emplace_back([&map, &hits, count, t] {
+          std::size_t state = t + 1, found = 0;
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            found += map.contains(static_cast<int>((state >> 33) % count));
+          }
+          hits += found;
+        });
+      for (auto &thread : threads)
+        thread.join();
+    });
+    done = true;
+    writer.join();
+
+    const double operations = static_cast<double>(count) * threadsCount;
+    std::cout << name << " with " << threadsCount << " readers: "
+              << operations / std::max<long long>(elapsed.count(), 1) / 1000 << " Mops/s" << std::endl;
+  }
+}
+
+// Startup from a saved table: rebuilding a HashMap item by item against
+// opening the flat file it saved and answering the first lookups from it.
+void benchmarkFlatFile(std::size_t count)
+{
+  const std::string path = "aisdiMaps.flat";
+  aisdi::HashMap<long long, long long> map;
+  auto rebuild = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      map[i * 7919] = i;
+  });
+  auto save = measureTime([&] { aisdi::saveFlat(map, path); });
+
+  std::size_t found = 0;
+  auto open = measureTime([&] {
+    aisdi::MappedHashMap<long long, long long> mapped(path);
+    for (size_t i = 0; i < 1000; i++)
+      found += mapped.contains(i * 7919);
+  });
+  auto lookup = measureTime([&] {
+    aisdi::MappedHashMap<long long, long long> mapped(path);
+    for (size_t i = 0; i < count; i++)
+      found += mapped.contains(i * 7919);
+  });
+  std::remove(path.c_str());
+
+  std::cout << "Building HashMap of " << count << " elements took: " << rebuild.count() << " miliseconds, saving it flat: "
+            << save.count() << " miliseconds" << std::endl;
+  std::cout << "Opening the flat file with 1000 lookups took: " << open.count() << " miliseconds, looking up all "
+            << count << " elements: " << lookup.count() << " miliseconds (" << found << " found)" << std::endl;
+}
+
+// Lookups of random keys, half of them missing, in a HashMap and in the
+// FrozenHashMap built from it on one thread and on all of them.
+void benchmarkFrozen(std::size_t count)
+{
+  aisdi::HashMap<int, int> map;
+  for (size_t i = 0; i < count; i++)
+    map[i * 2] = i;
+
+  std::unique_ptr<aisdi::FrozenHashMap<int, int>> frozen;
+  auto serialBuild = measureTime([&] { frozen.reset(new aisdi::FrozenHashMap<int, int>(map, 1)); });
+  auto parallelBuild = measureTime([&] { frozen.reset(new aisdi::FrozenHashMap<int, int>(map)); });
+
+  std::vector<int> keys(count);
+  for (auto &key : keys)
+    key = static_cast<int>((static_cast<std::size_t>(std::rand()) * RAND_MAX + std::rand()) % (2 * count));
+
+  std::size_t foundHashed = 0, foundFrozen = 0;
+  auto hashed = measureTime([&] {
+    for (auto key : keys)
+      foundHashed += map.find(key) != map.end();
+  });
+  auto lookup = measureTime([&] {
+    for (auto key : keys)
+      foundFrozen += frozen->contains(key);
+  });
+
+  std::cout << "Freezing HashMap of " << count << " elements took: " << serialBuild.count()
+            << " miliseconds on one thread, " << parallelBuild.count() << " miliseconds on "
+            << std::thread::hardware_concurrency() << " (" << frozen->functionBitsPerKey() << " bits per key)"
+            << std::endl;
+  std::cout << "Looking up " << count << " random keys took: " << hashed.count() << " miliseconds in HashMap, "
+            << lookup.count() << " miliseconds in FrozenHashMap (found " << foundHashed << " / " << foundFrozen << ")"
+            << std::endl;
+}
+
+// Moving every entry of one map to another: copied into the target and
+// removed from the source, extracted and inserted node by node, or merged.
+void benchmarkNodeMoves(std::size_t count)
+{
+  using Map = aisdi::HashMap<int, int>;
+  Map filled;
+  for (size_t i = 0; i < count; i++)
+    filled[i] = i;
+
+  Map source(filled), target;
+  target.reserve(count);
+  auto copy = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+    {
+      auto it = source.find(i);
+      target[it->first] = it->second;
+      source.remove(it);
+    }
+  });
+
+  source = filled;
+  target = Map();
+  target.reserve(count);
+  auto extract = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      target.insert(source.extract(i));
+  });
+
+  source = filled;
+  target = Map();
+  target.reserve(count);
+  auto merge = measureTime([&] { target.merge(source); });
+
+  std::cout << "Moving " << count << " elements between HashMaps took: " << copy.count()
+            << " miliseconds by copying, " << extract.count() << " miliseconds by extracting nodes, " << merge.count()
+            << " miliseconds by merging" << std::endl;
+}
+
+// Purging 30% of the entries: collecting their keys and removing them one by
+// one, removing them with erase() while iterating, or with erase_if().
+// Then reloading them, one by one and as a range.
+void benchmarkBulkOperations(std::size_t count)
+{
+  using Map = aisdi::HashMap<int, int>;
+  Map filled;
+  for (size_t i = 0; i < count; i++)
+    filled[i] = i;
+  auto isEvicted = [](const std::pair<int, int> &item) { return item.second % 10 < 3; };
+
+  // every variant purges its own copy, made right before it is timed
+  auto purge = [&](auto evict) {
+    Map map(filled);
+    return measureTime([&] { evict(map); });
+  };
+
+  auto byKey = purge([&](Map &map) {
+    std::vector<int> keys;
+    for (auto &item : map)
+      if (isEvicted(item))
+        keys.push_back(item.first);
+    for (auto key : keys)
+      map.remove(key);
+  });
+  auto byIterator = purge([&](Map &map) {
+    for (auto it = map.begin(); it != map.end();)
+      it = isEvicted(*it) ? map.erase(it) : ++it;
+  });
+  std::size_t removed = 0;
+  auto sweep = purge([&](Map &map) { removed = map.erase_if(isEvicted); });
+
+  std::cout << "Purging " << removed << " of " << count << " elements from HashMap took: " << byKey.count()
+            << " miliseconds by key, " << byIterator.count() << " miliseconds with erase(), " << sweep.count()
+            << " miliseconds with erase_if()" << std::endl;
+
+  std::vector<std::pair<int, int>> items;
+  for (size_t i = 0; i < count; i++)
+    items.emplace_back(static_cast<int>((i * 2654435761u) % (4 * count)), static_cast<int>(i));
+
+  auto oneByOne = measureTime([&] {
+    Map loaded;
+    for (auto &item : items)
+      loaded.try_emplace(item.first, item.second);
+  });
+  auto range = measureTime([&] {
+    Map loaded;
+    loaded.insert(items.begin(), items.end());
+  });
+
+  std::cout << "Inserting " << count << " random elements into HashMap took: " << oneByOne.count()
+            << " miliseconds one by one, " << range.count() << " miliseconds as a range" << std::endl;
+}
+
+// Short string keys, as in most identifier tables: memory, filling and
+// lookups of HashMap<std::string, int> against StringHashMap<int>.
+template <typename Map>
+void benchmarkStringKeys(const std::string &name, const std::vector<std::string> &keys)
+{
+  const auto before = heapInUse();
+  std::unique_ptr<Map> map(new Map);
+  auto fill = measureTime([&] {
+    for (std::size_t i = 0; i < keys.size(); i++)
+      (*map)[keys[i]] = static_cast<int>(i);
+  });
+  const auto after = heapInUse();
+
+  std::size_t sum = 0;
+  auto lookup = measureTime([&] {
+    for (auto &key : keys)
+      sum += map->valueOf(key);
+  });
+
+  std::cout << "Filling " << name << " with " << keys.size() << " string keys took: " << fill.count()
+            << " miliseconds, " << (after - before) / std::max<std::size_t>(keys.size(), 1)
+            << " bytes per element, looking all of them up: " << lookup.count() << " miliseconds (sum " << sum << ")"
+            << std::endl;
+}
+
+// Lookups in a table of 16 opcodes, built at runtime in a HashMap and at
+// compile time in a ConstexprMap.
+void benchmarkOpcodeTable(std::size_t count)
+{
+  static constexpr auto compiled = aisdi::makeConstexprMap<int, int>(
+      { { 0x90, 0 }, { 0xc3, 1 }, { 0xe8, 2 }, { 0xe9, 3 }, { 0xeb, 4 }, { 0x50, 5 }, { 0x58, 6 }, { 0x89, 7 },
+        { 0x8b, 8 }, { 0x01, 9 }, { 0x29, 10 }, { 0x31, 11 }, { 0x39, 12 }, { 0x74, 13 }, { 0x75, 14 }, { 0xcc, 15 } });
+  aisdi::HashMap<int, int> built;
+  for (auto &item : compiled)
+    built[item.first] = item.second;
+
+  std::vector<int> codes(count);
+  for (auto &code : codes)
+    code = std::rand() % 0x100;
+
+  std::size_t foundBuilt = 0, foundCompiled = 0;
+  auto runtime = measureTime([&] {
+    for (auto code : codes)
+      foundBuilt += built.find(code) != built.end();
+  });
+  auto compileTime = measureTime([&] {
+    for (auto code : codes)
+      foundCompiled += compiled.contains(code);
+  });
+
+  std::cout << "Looking up " << count << " opcodes took: " << runtime.count() << " miliseconds in HashMap, "
+            << compileTime.count() << " miliseconds in ConstexprMap (found " << foundBuilt << " / " << foundCompiled
+            << ")" << std::endl;
+}
+
+// Hashes that put many keys into one bucket: the same hash for all of them,
+// or the same hash for every run of 1024 consecutive keys.
+struct ConstantHash
+{
+  std::size_t operator()(int) const
+  {
+    return 42;
+  }
+};
+
+struct CoarseHash
+{
+  std::size_t operator()(int key) const
+  {
+    return static_cast<std::size_t>(key) >> 10;
+  }
+};
+
+// Inserts and then looks up every key of a map whose chains all collide.
+template <typename Map>
+void benchmarkCollisions(const std::string &name, std::size_t count)
+{
+  Map map;
+  auto append = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      map[i] = i;
+  });
+
+  std::size_t found = 0;
+  auto lookup = measureTime([&] {
+    for (size_t i = 0; i < count; i++)
+      found += map.find(i) != map.end();
+  });
+
+  std::cout << "Colliding " << name << " with " << count << " elements: inserts took " << append.count()
+            << " miliseconds, lookups took " << lookup.count() << " miliseconds (" << found << " found)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::srand(std::time(nullptr)); // use current time as seed for random generator
+  const long long requested = argc > 1 ? std::atoll(argv[1]) : 10000;
+  if (requested <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " [count > 0] [mode]" << std::endl;
+    return 1;
+  }
+  const std::size_t count = requested;
+
+  // "aisdiMaps <count> lookup" only compares scalar and batched lookups;
+  // pick a count whose table outgrows the last-level cache, e.g. 4000000.
+  if (argc > 2 && std::string(argv[2]) == "lookup")
+  {
+    benchmarkBatchLookup<aisdi::HashMap<int, int>>("HashMap", count);
+    benchmarkBatchLookup<aisdi::CompactHashMap<int, int>>("CompactHashMap", count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> misses" shows what the Bloom filter saves on lookups
+  // that mostly miss; like "lookup", it wants tables larger than the cache.
+  if (argc > 2 && std::string(argv[2]) == "misses")
+  {
+    for (int missRatio : { 0, 80, 100 })
+    {
+      benchmarkMisses(count, missRatio, false);
+      benchmarkMisses(count, missRatio, true);
+    }
+    return 0;
+  }
+
+  // "aisdiMaps <count> concurrent" measures throughput from 1 to 64 threads.
+  if (argc > 2 && std::string(argv[2]) == "concurrent")
+  {
+    benchmarkConcurrent<LockedHashMap>("HashMap behind one mutex", count);
+    benchmarkConcurrent<aisdi::ConcurrentHashMap<int, int>>("ConcurrentHashMap", count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> lockfree" adds tail latencies to the thread sweep.
+  if (argc > 2 && std::string(argv[2]) == "lockfree")
+  {
+    benchmarkMixedLatency<LockedHashMap>("HashMap behind one mutex", count);
+    benchmarkMixedLatency<aisdi::LockFreeHashMap<int, int>>("LockFreeHashMap", count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> readmostly" sweeps readers against a slow writer.
+  if (argc > 2 && std::string(argv[2]) == "readmostly")
+  {
+    benchmarkReadMostly<aisdi::ConcurrentHashMap<int, int>>("ConcurrentHashMap", count);
+    benchmarkReadMostly<aisdi::SnapshotHashMap<int, int>>("SnapshotHashMap", count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> flat" compares rebuilding a table with mapping a saved one.
+  if (argc > 2 && std::string(argv[2]) == "flat")
+  {
+    benchmarkFlatFile(count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> frozen" builds a FrozenHashMap and compares lookups.
+  if (argc > 2 && std::string(argv[2]) == "frozen")
+  {
+    benchmarkFrozen(count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> strings" compares string-keyed maps.
+  if (argc > 2 && std::string(argv[2]) == "strings")
+  {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; i++)
+      keys.push_back("user" + std::to_string(i * 2654435761u % (4 * count)));
+    benchmarkStringKeys<aisdi::HashMap<std::string, int>>("HashMap", keys);
+    benchmarkStringKeys<aisdi::StringHashMap<int>>("StringHashMap", keys);
+    return 0;
+  }
+
+  // "aisdiMaps <count> bulk" compares purges and loads done item by item
+  // with erase_if() and range insert.
+  if (argc > 2 && std::string(argv[2]) == "bulk")
+  {
+    benchmarkBulkOperations(count);
+    return 0;
+  }
+
+  // "aisdiMaps <count> collisions" feeds degenerate hashes to chains that
+  // can turn into trees and to forward lists that cannot.
+  if (argc > 2 && std::string(argv[2]) == "collisions")
+  {
+    benchmarkCollisions<aisdi::HashMap<int, int, ConstantHash>>("HashMap (constant hash)", count);
+    benchmarkCollisions<aisdi::CompactHashMap<int, int, ConstantHash>>("CompactHashMap (constant hash)", count);
+    benchmarkCollisions<aisdi::HashMap<int, int, CoarseHash>>("HashMap (coarse hash)", count);
+    benchmarkCollisions<aisdi::CompactHashMap<int, int, CoarseHash>>("CompactHashMap (coarse hash)", count);
+    return 0;
+  }
+
+  benchmarkMemory<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkMemory<aisdi::HashMap<int, int, std::hash<int>, std::equal_to<int>, aisdi::PowerOfTwoIndexing, false,
+                                 aisdi::PoolAllocator<std::pair<int, int>>>>("HashMap (pooled nodes)", count);
+  benchmarkMemory<aisdi::CompactHashMap<int, int>>("CompactHashMap", count);
+  benchmarkMemory<aisdi::HashMap<int, bool>>("HashMap<int, bool>", count);
+  benchmarkSetMemory<aisdi::HashSet<int>>("HashSet<int>", count);
+  benchmarkMemory<aisdi::HashMap<long long, bool>>("HashMap<long long, bool>", count);
+  benchmarkSetMemory<aisdi::HashSet<long long>>("HashSet<long long>", count);
+  benchmarkMemory<aisdi::TreeMap<int, char>>("TreeMap<int, char>", count);
+  benchmarkSetMemory<aisdi::TreeSet<int>>("TreeSet<int>", count);
+  benchmarkMemory<aisdi::TreeMap<long long, char>>("TreeMap<long long, char>", count);
+  benchmarkSetMemory<aisdi::TreeSet<long long>>("TreeSet<long long>", count);
+
+  benchmarkMap<aisdi::TreeMap<int, int>>("TreeMap", count);
+  benchmarkMap<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkMap<aisdi::HashMap<int, int, std::hash<int>, std::equal_to<int>, aisdi::ModuloIndexing>>("HashMap (modulo indexing)", count);
+  benchmarkMap<aisdi::CompactHashMap<int, int>>("CompactHashMap", count);
+  benchmarkMap<aisdi::SwissHashMap<int, int>>("SwissHashMap", count);
+  benchmarkMap<aisdi::RobinHoodHashMap<int, int>>("RobinHoodHashMap", count);
+  benchmarkMap<aisdi::DenseHashMap<int, int>>("DenseHashMap", count);
+
+  benchmarkChurn<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkChurn<aisdi::SwissHashMap<int, int>>("SwissHashMap", count);
+  benchmarkChurn<aisdi::RobinHoodHashMap<int, int>>("RobinHoodHashMap", count);
+
+  benchmarkStringKeys<aisdi::HashMap<std::string, int>>("HashMap", count);
+  benchmarkStringKeys<aisdi::HashMap<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+                                     aisdi::PowerOfTwoIndexing, true>>("HashMap (stored hashes)", count);
+
+  benchmarkInsertLatency("HashMap (immediate rehash)", count, aisdi::RehashMode::Immediate);
+  benchmarkInsertLatency("HashMap (incremental rehash)", count, aisdi::RehashMode::Incremental);
+
+  benchmarkBulkLoad("HashMap", count, false);
+  benchmarkBulkLoad("HashMap (reserved)", count, true);
+
+  benchmarkSparseIteration<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkSparseIteration<aisdi::CompactHashMap<int, int>>("CompactHashMap", count);
+
+  benchmarkScan<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkScan<aisdi::SwissHashMap<int, int>>("SwissHashMap", count);
+  benchmarkScan<aisdi::DenseHashMap<int, int>>("DenseHashMap", count);
+  benchmarkVectorScan(count);
+
+  benchmarkSmallMaps<aisdi::HashMap<int, int>>("HashMap", count);
+  benchmarkSmallMaps<aisdi::SmallHashMap<int, int>>("SmallHashMap", count);
+  benchmarkSmallMaps<aisdi::TreeMap<int, int>>("TreeMap", count);
+  benchmarkSmallMaps<aisdi::SmallTreeMap<int, int>>("SmallTreeMap", count);
+
+  benchmarkNodeMoves(count);
+  benchmarkBulkOperations(count);
+  benchmarkOpcodeTable(count);
 
-  std::cout << "Appending " << count<< " elements to TreeMap took: " << treeAppend.count() << " miliseconds" << std::endl;
-  std::cout << "Appending " << count<< " elements to HashMap took: " << hashAppend.count() << " miliseconds" << std::endl;
-  std::cout << "Removing " << count<< " elements from TreeMap took: " << treeRemove.count() << " miliseconds" << std::endl;
-  std::cout << "Removing " << count<< " elements from HashMap took: " << hashRemove.count() << " miliseconds" << std::endl;
-  std::cout << "Finding " << count<< " elements from TreeMap took: " << treeFind.count() << " miliseconds" << std::endl;
-  std::cout << "Finding " << count<< " elements from HashMap took: " << hashFind.count() << " miliseconds" << std::endl;
+  benchmarkSetOperations<aisdi::HashSet<int>>("HashSet", count);
+  benchmarkSetOperations<aisdi::TreeSet<int>>("TreeSet", count);
 
   return 0;
 }
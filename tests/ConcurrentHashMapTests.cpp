@@ -0,0 +1,163 @@
+#include "../src/ConcurrentHashMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+using Map = aisdi::ConcurrentHashMap<std::int32_t, std::int32_t>;
+
+template <typename Function>
+void runInThreads(std::size_t threadsCount, Function function)
+{
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadsCount; ++i)
+    threads.emplace_back(function, i);
+  for (auto& thread : threads)
+    thread.join();
+}
+
+const std::size_t threadsCount = 8;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ConcurrentHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenShardCount_WhenCreatingMap_ThenItIsRoundedToPowerOfTwo)
+{
+  Map map(6);
+
+  BOOST_CHECK_EQUAL(map.getShardCount(), 8);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenUpserting_ThenItemIsInsertedThenAssigned)
+{
+  Map map;
+
+  BOOST_CHECK(map.upsert(42, 1));
+  BOOST_CHECK(!map.upsert(42, 2));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), 2);
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptyMap_WhenUpsertingWithUpdate_ThenPresentValueIsUpdated)
+{
+  Map map;
+  map.upsert(42, 1);
+
+  BOOST_CHECK(!map.upsert(42, 100, [](std::int32_t& value) { value += 10; }));
+  BOOST_CHECK(map.upsert(27, 100, [](std::int32_t& value) { value += 10; }));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), 11);
+  BOOST_CHECK_EQUAL(map.valueOf(27), 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingKey_WhenReadingValue_ThenExceptionIsThrown)
+{
+  const Map map;
+
+  BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
+  BOOST_CHECK(!map.contains(1));
+  BOOST_CHECK(!map.visit(1, [](const std::int32_t&) {}));
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptyMap_WhenErasingIf_ThenOnlyMatchingValueIsRemoved)
+{
+  Map map;
+  map.upsert(1, 10);
+  map.upsert(2, 20);
+
+  BOOST_CHECK(!map.erase_if(1, [](const std::int32_t& value) { return value > 15; }));
+  BOOST_CHECK(map.erase_if(2, [](const std::int32_t& value) { return value > 15; }));
+  BOOST_CHECK(!map.remove(3));
+
+  BOOST_CHECK(map.contains(1));
+  BOOST_CHECK(!map.contains(2));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyItems_WhenVisitingAll_ThenEachItemIsVisitedOnce)
+{
+  Map map(4);
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    map.upsert(i, -i);
+    expected[i] = -i;
+  }
+
+  std::map<std::int32_t, std::int32_t> visited;
+  map.forEach([&](const Map::value_type& item) { visited.insert(item); });
+
+  BOOST_CHECK(visited == expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenIncrementingSharedCounters_ThenNoUpdateIsLost)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+
+  runInThreads(threadsCount, [&](std::size_t) {
+    for (std::int32_t i = 0; i < 20000; ++i)
+      map.upsert(i % 500, 1, [](std::int32_t& value) { ++value; });
+  });
+
+  BOOST_CHECK_EQUAL(map.getSize(), 500);
+  for (std::int32_t key = 0; key < 500; ++key)
+    BOOST_REQUIRE_EQUAL(map.valueOf(key), static_cast<std::int32_t>(threadsCount * 20000 / 500));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenComputingIfAbsent_ThenFactoryRunsOncePerKey)
+{
+  aisdi::ConcurrentHashMap<std::int32_t, std::string> map;
+  std::atomic<std::size_t> factoryCalls(0);
+  std::atomic<std::size_t> wrongValues(0);
+
+  // Boost.Test assertions are not thread-safe, workers only count failures.
+  runInThreads(threadsCount, [&](std::size_t) {
+    for (std::int32_t i = 0; i < 5000; ++i)
+    {
+      auto value = map.compute_if_absent(i, [&] {
+        ++factoryCalls;
+        return std::to_string(i);
+      });
+      if (value != std::to_string(i))
+        ++wrongValues;
+    }
+  });
+
+  BOOST_CHECK_EQUAL(factoryCalls.load(), 5000);
+  BOOST_CHECK_EQUAL(wrongValues.load(), 0);
+  BOOST_CHECK_EQUAL(map.getSize(), 5000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenInsertingAndRemovingDisjointKeys_ThenOnlyKeptKeysRemain)
+{
+  Map map;
+
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    const auto base = static_cast<std::int32_t>(thread * 100000);
+    for (std::int32_t i = 0; i < 10000; ++i)
+      map.upsert(base + i, i);
+    for (std::int32_t i = 0; i < 10000; i += 2)
+      map.remove(base + i);
+  });
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadsCount * 5000);
+  for (std::size_t thread = 0; thread < threadsCount; ++thread)
+  {
+    const auto base = static_cast<std::int32_t>(thread * 100000);
+    BOOST_REQUIRE(!map.contains(base + 10));
+    BOOST_REQUIRE_EQUAL(map.valueOf(base + 11), 11);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#include "../src/ConstexprMap.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+enum class Opcode
+{
+  Nop,
+  Ret,
+  Call,
+  Jump
+};
+
+constexpr auto opcodes = aisdi::makeConstexprMap<int, Opcode>(
+    { { 0xe9, Opcode::Jump }, { 0x90, Opcode::Nop }, { 0xc3, Opcode::Ret }, { 0xe8, Opcode::Call } });
+
+constexpr auto keywords = aisdi::makeConstexprMap<const char *, int>(
+    { { "while", 1 }, { "if", 2 }, { "for", 3 }, { "else", 4 }, { "return", 5 }, { "do", 6 }, { "break", 7 } },
+    aisdi::CStringLess());
+
+static_assert(opcodes.valueOf(0xc3) == Opcode::Ret, "Opcode looked up during compilation");
+static_assert(!opcodes.contains(0xcc), "Missing opcode found during compilation");
+static_assert(keywords.valueOf("return") == 5, "Keyword looked up during compilation");
+static_assert(keywords.begin()->second == 7, "Items are not sorted by key");
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ConstexprMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenCompileTimeMap_WhenLookingUpRuntimeKeys_ThenItemsAreFound)
+{
+  const int codes[] = { 0x90, 0xc3, 0xe8, 0xe9 };
+  const Opcode expected[] = { Opcode::Nop, Opcode::Ret, Opcode::Call, Opcode::Jump };
+  for (int i = 0; i < 4; ++i)
+  {
+    auto it = opcodes.find(codes[i]);
+    BOOST_REQUIRE(it != opcodes.end());
+    BOOST_CHECK(it->second == expected[i]);
+  }
+  for (int code = 0; code < 0x100; ++code)
+    BOOST_CHECK_EQUAL(opcodes.contains(code), code == 0x90 || code == 0xc3 || code == 0xe8 || code == 0xe9);
+  BOOST_CHECK_THROW(opcodes.valueOf(0xcc), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeys_WhenLookingThemUp_ThenCharactersAreCompared)
+{
+  std::string word = "break";
+  BOOST_CHECK_EQUAL(keywords.valueOf(word.c_str()), 7);
+  BOOST_CHECK(!keywords.contains("whilst"));
+  BOOST_CHECK(!keywords.contains("d"));
+  BOOST_CHECK(!keywords.contains(""));
+
+  std::string previous;
+  for (auto& item : keywords)
+  {
+    BOOST_CHECK_LT(previous, item.first);
+    previous = item.first;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenDuplicateKeys_WhenBuildingMapAtRuntime_ThenItThrows)
+{
+  int one = 1;
+  BOOST_CHECK_THROW((aisdi::makeConstexprMap<int, int>({ { one, 1 }, { 2, 2 }, { one, 3 } })), std::invalid_argument);
+  BOOST_CHECK_THROW(*opcodes.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+#include "../src/DenseHashMap.h"
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+// The generic map behaviour is covered by HashMapTests.cpp, which is also built
+// against DenseHashMap. Here we only check the dense layout and its index.
+
+using Map = aisdi::DenseHashMap<std::int32_t, std::int32_t>;
+
+namespace
+{
+
+void thenMapContainsItems(const Map& map, const std::map<std::int32_t, std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  std::size_t iterated = 0;
+  for (const auto& item : map)
+  {
+    auto it = expected.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != expected.end(), "Unexpected key: " << item.first);
+    BOOST_CHECK_EQUAL(item.second, it->second);
+    ++iterated;
+  }
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(map.find(item.first) != map.end(), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  }
+}
+
+// Value whose copies start throwing once copiesLeft runs out.
+class CopyLimitedValue
+{
+public:
+  explicit CopyLimitedValue(int value_) : value(value_)
+  {
+    ++alive;
+  }
+
+  CopyLimitedValue(const CopyLimitedValue& other) : value(other.value)
+  {
+    if (copiesLeft == 0)
+      throw std::runtime_error("Copy limit reached");
+    --copiesLeft;
+    ++alive;
+  }
+
+  ~CopyLimitedValue()
+  {
+    --alive;
+  }
+
+  CopyLimitedValue& operator=(const CopyLimitedValue&) = default;
+
+  int value;
+
+  static std::size_t copiesLeft;
+  static std::size_t alive;
+};
+
+std::size_t CopyLimitedValue::copiesLeft = static_cast<std::size_t>(-1);
+std::size_t CopyLimitedValue::alive = 0;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DenseHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenAddingItems_ThenTheyAreIteratedInInsertionOrder)
+{
+  Map map;
+  std::vector<std::int32_t> keys;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    keys.push_back((i * 7919) % 1000);
+    map[keys.back()] = i;
+  }
+
+  std::vector<std::int32_t> iterated;
+  for (auto& item : map)
+    iterated.push_back(item.first);
+
+  BOOST_CHECK(iterated == keys);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptyMap_WhenRemovingItem_ThenLastItemTakesItsPlace)
+{
+  Map map = { { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 } };
+
+  map.remove(2);
+
+  std::vector<std::int32_t> iterated;
+  for (auto& item : map)
+    iterated.push_back(item.first);
+  BOOST_CHECK(iterated == std::vector<std::int32_t>({ 1, 4, 3 }));
+  BOOST_CHECK_EQUAL(map.valueOf(4), 40);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenRemovingAndAddingRepeatedly_ThenContentIsConsistent)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t round = 0; round < 20; ++round)
+  {
+    for (std::int32_t i = 0; i < 300; ++i)
+    {
+      map[round * 1000 + i] = i;
+      expected[round * 1000 + i] = i;
+    }
+    for (std::int32_t i = 0; i < 300; i += 2)
+    {
+      map.remove(round * 1000 + i);
+      expected.erase(round * 1000 + i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFullMap_WhenRemovingEveryItemThroughBegin_ThenMapIsEmpty)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 500; ++i)
+    map[i] = i;
+
+  while (!map.isEmpty())
+  {
+    auto key = map.begin()->first;
+    map.remove(map.begin());
+    BOOST_REQUIRE(map.find(key) == map.end());
+  }
+
+  BOOST_CHECK(map.begin() == map.end());
+  map[1] = 1;
+  BOOST_CHECK_EQUAL(map.valueOf(1), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCopiedMap_WhenChangingOriginal_ThenCopyIsUnchanged)
+{
+  aisdi::DenseHashMap<std::int32_t, std::string> map = { { 1, "Alice" }, { 2, "Bob" } };
+  auto copy = map;
+
+  map.remove(1);
+  map[3] = "Chuck";
+
+  BOOST_CHECK_EQUAL(copy.getSize(), 2);
+  BOOST_CHECK_EQUAL(copy.valueOf(1), "Alice");
+  BOOST_CHECK(copy.find(3) == copy.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenValueWhoseCopyThrows_WhenCopyingMap_ThenCopiedValuesAreDestroyed)
+{
+  {
+    using ValueMap = aisdi::DenseHashMap<std::int32_t, CopyLimitedValue>;
+    ValueMap map;
+    for (std::int32_t i = 0; i < 100; ++i)
+      map.try_emplace(i, i);
+
+    CopyLimitedValue::copiesLeft = 50;
+    BOOST_CHECK_THROW(ValueMap copy(map), std::runtime_error);
+    CopyLimitedValue::copiesLeft = static_cast<std::size_t>(-1);
+    BOOST_CHECK_EQUAL(CopyLimitedValue::alive, 100u);
+  }
+  BOOST_CHECK_EQUAL(CopyLimitedValue::alive, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
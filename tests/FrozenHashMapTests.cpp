@@ -0,0 +1,118 @@
+#include "../src/FrozenHashMap.h"
+#include "../src/HashMap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+struct ConstantHash
+{
+  std::size_t operator()(int) const
+  {
+    return 42;
+  }
+};
+
+using Items = std::vector<std::pair<std::uint64_t, int>>;
+
+Items randomItems(std::size_t count)
+{
+  std::mt19937_64 random(count);
+  Items items;
+  for (std::size_t i = 0; i < count; ++i)
+    items.emplace_back(random(), static_cast<int>(i));
+  return items;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FrozenHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenItems_WhenFreezingThem_ThenEveryKeyIsFoundAndNoOtherOne)
+{
+  auto items = randomItems(20000);
+  aisdi::FrozenHashMap<std::uint64_t, int> map(items.begin(), items.end());
+
+  BOOST_CHECK_EQUAL(map.getSize(), items.size());
+  for (auto& item : items)
+  {
+    auto it = map.find(item.first);
+    BOOST_REQUIRE(it != map.end());
+    BOOST_CHECK_EQUAL(it->second, item.second);
+  }
+
+  std::mt19937_64 other(1);
+  for (int i = 0; i < 20000; ++i)
+    BOOST_CHECK(!map.contains(other()));
+
+  std::map<std::uint64_t, int> iterated(map.begin(), map.end());
+  std::map<std::uint64_t, int> expected(items.begin(), items.end());
+  BOOST_CHECK(iterated == expected);
+  BOOST_CHECK_LT(map.functionBitsPerKey(), 3.5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHashMap_WhenFreezingIt_ThenItemsAreTheSame)
+{
+  aisdi::HashMap<std::string, int> source;
+  for (int i = 0; i < 1000; ++i)
+    source["code" + std::to_string(i)] = i;
+
+  aisdi::FrozenHashMap<std::string, int> map(source);
+
+  BOOST_CHECK_EQUAL(map.getSize(), source.getSize());
+  for (auto& item : source)
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  BOOST_CHECK(!map.contains("code1000"));
+  BOOST_CHECK_THROW(map.valueOf("PL"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDuplicateKeys_WhenFreezing_ThenFirstItemIsKept)
+{
+  const aisdi::FrozenHashMap<int, std::string> map = { { 1, "one" }, { 2, "two" }, { 1, "uno" }, { 2, "dos" } };
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+  BOOST_CHECK_EQUAL(map.valueOf(1), "one");
+  BOOST_CHECK_EQUAL(map.valueOf(2), "two");
+}
+
+BOOST_AUTO_TEST_CASE(GivenDistinctKeysWithEqualHashes_WhenFreezing_ThenItThrows)
+{
+  std::vector<std::pair<int, int>> items = { { 1, 1 }, { 2, 2 } };
+  using Map = aisdi::FrozenHashMap<int, int, ConstantHash>;
+
+  BOOST_CHECK_THROW(Map(items.begin(), items.end()), std::invalid_argument);
+  BOOST_CHECK_EQUAL(Map(items.begin(), items.begin() + 1).valueOf(1), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyRange_WhenFreezing_ThenMapIsEmpty)
+{
+  Items items;
+  aisdi::FrozenHashMap<std::uint64_t, int> map(items.begin(), items.end());
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(map.find(0) == map.end());
+  BOOST_CHECK_THROW(map.valueOf(0), std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMoreThreads_WhenFreezing_ThenTheSameMapIsBuilt)
+{
+  auto items = randomItems(30000);
+  aisdi::FrozenHashMap<std::uint64_t, int> alone(items.begin(), items.end(), 1);
+  aisdi::FrozenHashMap<std::uint64_t, int> together(items.begin(), items.end(), 4);
+
+  BOOST_CHECK(std::equal(alone.begin(), alone.end(), together.begin(), together.end()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
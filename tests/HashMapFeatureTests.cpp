@@ -0,0 +1,1112 @@
+#include "../src/HashMap.h"
+#include "../src/HashUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// HashMapTests.cpp holds the map contract shared by every hash map engine.
+// This file covers what only the chained HashMap offers.
+
+namespace
+{
+
+using Map = aisdi::HashMap<std::int32_t, std::int32_t>;
+
+template <typename M>
+void thenMapContainsItems(const M& map, const std::map<std::int32_t, std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  std::size_t iterated = 0;
+  for (const auto& item : map)
+  {
+    auto it = expected.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != expected.end(), "Unexpected key: " << item.first);
+    BOOST_CHECK_EQUAL(item.second, it->second);
+    ++iterated;
+  }
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(map.find(item.first) != map.end(), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  }
+}
+
+// Inserts keys until the map is in the middle of an incremental migration.
+void fillUntilRehashing(Map& map, std::map<std::int32_t, std::int32_t>& expected, std::int32_t minimum)
+{
+  std::int32_t i = 0;
+  while (i < minimum || !map.isRehashing())
+  {
+    map[i] = i * 2;
+    expected[i] = i * 2;
+    ++i;
+  }
+}
+
+struct CaseInsensitiveHash
+{
+  std::size_t operator()(const std::string& key) const
+  {
+    std::string lower;
+    for (auto c : key)
+      lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return std::hash<std::string>{}(lower);
+  }
+};
+
+struct CaseInsensitiveEqual
+{
+  bool operator()(const std::string& lhs, const std::string& rhs) const
+  {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+             return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+           });
+  }
+};
+
+struct CountingHash
+{
+  std::size_t operator()(std::int32_t key) const
+  {
+    ++calls;
+    return std::hash<std::int32_t>{}(key);
+  }
+
+  static std::size_t calls;
+};
+
+std::size_t CountingHash::calls = 0;
+
+struct CollidingHash
+{
+  std::size_t operator()(std::int32_t) const
+  {
+    return 42;
+  }
+};
+
+// Key whose comparisons are counted; all of them hash alike.
+struct CountedKey
+{
+  std::int32_t value;
+
+  friend bool operator==(const CountedKey& lhs, const CountedKey& rhs)
+  {
+    ++comparisons;
+    return lhs.value == rhs.value;
+  }
+
+  friend bool operator<(const CountedKey& lhs, const CountedKey& rhs)
+  {
+    return lhs.value < rhs.value;
+  }
+
+  static std::size_t comparisons;
+};
+
+std::size_t CountedKey::comparisons = 0;
+
+struct CountedKeyCollidingHash
+{
+  std::size_t operator()(const CountedKey&) const
+  {
+    return 42;
+  }
+};
+
+// Distinct hashes that all fall into bucket 0 under modulo indexing.
+struct MultipleOfBucketsHash
+{
+  std::size_t operator()(std::int32_t key) const
+  {
+    return static_cast<std::size_t>(key) << 32;
+  }
+};
+
+struct CountingEqual
+{
+  bool operator()(std::int32_t lhs, std::int32_t rhs) const
+  {
+    ++calls;
+    return lhs == rhs;
+  }
+
+  static std::size_t calls;
+};
+
+std::size_t CountingEqual::calls = 0;
+
+std::size_t allocationsCount = 0;
+
+template <typename T>
+struct CountingAllocator
+{
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&)
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    ++allocationsCount;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* pointer, std::size_t n)
+  {
+    std::allocator<T>().deallocate(pointer, n);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const
+  {
+    return false;
+  }
+};
+
+struct SeededHash
+{
+  std::size_t operator()(std::int32_t key) const
+  {
+    return std::hash<std::int32_t>{}(key) ^ seed;
+  }
+
+  std::size_t seed;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HashMapFeatureTests)
+
+BOOST_AUTO_TEST_CASE(GivenIncrementalMap_WhenGrowing_ThenOldTableIsDrainedStepByStep)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+
+  fillUntilRehashing(map, expected, 100);
+  thenMapContainsItems(map, expected);
+
+  while (map.isRehashing())
+  {
+    auto key = static_cast<std::int32_t>(expected.size());
+    map[key] = key * 2;
+    expected[key] = key * 2;
+  }
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLowMaxLoadFactor_WhenGrowingIncrementally_ThenMigrationEndsBeforeNextGrowth)
+{
+  for (auto factor : { 0.1f, 0.25f, 0.5f, 4.0f })
+  {
+    Map map;
+    map.setRehashMode(aisdi::RehashMode::Incremental);
+    map.max_load_factor(factor);
+    std::map<std::int32_t, std::int32_t> expected;
+
+    for (std::int32_t i = 0; i < 20000; ++i)
+    {
+      const bool wasRehashing = map.isRehashing();
+      const auto buckets = map.bucket_count();
+      map[i] = i;
+      expected[i] = i;
+      if (map.bucket_count() != buckets)
+        BOOST_REQUIRE_MESSAGE(!wasRehashing, "Migration cut short at size " << i << ", load factor " << factor);
+    }
+    thenMapContainsItems(map, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenRemovingItems_ThenBothTablesAreSearched)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+
+  for (std::int32_t key = 0; key < 100; key += 3)
+  {
+    map.remove(key);
+    expected.erase(key);
+  }
+  map.remove(map.find(1));
+  expected.erase(1);
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenIteratingBackwards_ThenEveryItemIsVisited)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+  BOOST_REQUIRE(map.isRehashing());
+
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+
+  BOOST_CHECK_EQUAL(visited, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenCopying_ThenCopyIsEqual)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+
+  Map other(map);
+  BOOST_CHECK(other == map);
+  thenMapContainsItems(other, expected);
+
+  other[-1] = 0;
+  BOOST_CHECK(map.find(-1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenSwitchingToImmediateMode_ThenMigrationIsFinished)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+
+  map.setRehashMode(aisdi::RehashMode::Immediate);
+
+  BOOST_CHECK(!map.isRehashing());
+  thenMapContainsItems(map, expected);
+}
+
+using IndexPolicies = boost::mpl::list<aisdi::PowerOfTwoIndexing, aisdi::ModuloIndexing>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIndexPolicy_WhenAddingSequentialKeys_ThenAllItemsAreInMap,
+                              Policy,
+                              IndexPolicies)
+{
+  for (auto mode : { aisdi::RehashMode::Immediate, aisdi::RehashMode::Incremental })
+  {
+    aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, std::equal_to<std::int32_t>, Policy> map;
+    map.setRehashMode(mode);
+    std::map<std::int32_t, std::int32_t> expected;
+
+    for (std::int32_t i = 0; i < 3000; ++i)
+    {
+      map[i] = -i;
+      expected[i] = -i;
+    }
+    for (std::int32_t i = 0; i < 3000; i += 4)
+    {
+      map.remove(i);
+      expected.erase(i);
+    }
+
+    thenMapContainsItems(map, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenModuloIndexing_WhenInitializingFromOddSizedList_ThenAllItemsAreInMap)
+{
+  const aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, std::equal_to<std::int32_t>,
+                     aisdi::ModuloIndexing> map =
+    { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 }, { 6, 6 }, { 7, 7 }, { 8, 8 }, { 9, 9 } };
+
+  thenMapContainsItems(map, { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 }, { 6, 6 }, { 7, 7 }, { 8, 8 }, { 9, 9 } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenPowerOfTwoIndexing_WhenRequestingBuckets_ThenCountIsRoundedUp)
+{
+  BOOST_CHECK_EQUAL(aisdi::PowerOfTwoIndexing::bucketCount(9), 16u);
+  BOOST_CHECK_EQUAL(aisdi::PowerOfTwoIndexing::bucketCount(16), 16u);
+  BOOST_CHECK_EQUAL(aisdi::ModuloIndexing::bucketCount(9), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCustomHashAndEquality_WhenSearchingForEquivalentKey_ThenItemIsFound)
+{
+  aisdi::HashMap<std::string, std::int32_t, CaseInsensitiveHash, CaseInsensitiveEqual> map;
+  map["Alice"] = 1;
+  map["BOB"] = 2;
+
+  map["alice"] = 3;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(map.valueOf("ALICE"), 3);
+  BOOST_CHECK_EQUAL(map.find("bob")->second, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredHashes_WhenGrowing_ThenKeysAreHashedOncePerOperation)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CountingHash, std::equal_to<std::int32_t>,
+                 aisdi::PowerOfTwoIndexing, true> map;
+  CountingHash::calls = 0;
+
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  BOOST_CHECK_EQUAL(CountingHash::calls, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoStoredHashes_WhenGrowing_ThenKeysAreRehashed)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CountingHash> map;
+  CountingHash::calls = 0;
+
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  BOOST_CHECK_GT(CountingHash::calls, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCollidingHash_WhenAddingAndRemovingItems_ThenAllItemsAreFound)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash> map;
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash, std::equal_to<std::int32_t>,
+                 aisdi::PowerOfTwoIndexing, true> storedHashMap;
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t i = 0; i < 200; ++i)
+  {
+    map[i] = i;
+    storedHashMap[i] = i;
+    expected[i] = i;
+  }
+  for (std::int32_t i = 0; i < 200; i += 2)
+  {
+    map.remove(i);
+    storedHashMap.remove(i);
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  thenMapContainsItems(storedHashMap, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEqualHashesOfOrderedKeys_WhenSearching_ThenChainTreeIsUsed)
+{
+  aisdi::HashMap<CountedKey, std::int32_t, CountedKeyCollidingHash> map;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[CountedKey{ (i * 7919) % 1000 }] = i;
+  CountedKey::comparisons = 0;
+
+  for (std::int32_t i = 0; i < 1000; ++i)
+    BOOST_REQUIRE(map.find(CountedKey{ i }) != map.end());
+  BOOST_CHECK(map.find(CountedKey{ 1000 }) == map.end());
+
+  // a single chain scanned linearly would take half a million
+  BOOST_CHECK_LE(CountedKey::comparisons, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDistinctHashesInOneBucket_WhenSearching_ThenChainTreeIsUsed)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, MultipleOfBucketsHash, CountingEqual, aisdi::ModuloIndexing> map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+  CountingEqual::calls = 0;
+
+  for (std::int32_t i = 0; i < 1000; ++i)
+    BOOST_REQUIRE_EQUAL(map.valueOf(i), i);
+
+  BOOST_CHECK_LE(CountingEqual::calls, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTreeifiedChains_WhenShrinkingGrowingAndCopying_ThenAllItemsAreFound)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash> map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t round = 0; round < 3; ++round)
+  {
+    for (std::int32_t i = 0; i < 300; ++i)
+    {
+      map[i] = i + round;
+      expected[i] = i + round;
+    }
+    // down across both thresholds, so that the tree is dropped and rebuilt
+    for (std::int32_t i = 0; i < 298; ++i)
+    {
+      map.remove(map.find(i));
+      expected.erase(i);
+    }
+    thenMapContainsItems(map, expected);
+  }
+  for (std::int32_t i = 0; i < 100; ++i)
+  {
+    map[i] = i;
+    expected[i] = i;
+  }
+
+  auto copy = map;
+  copy.rehash(1024);
+  thenMapContainsItems(copy, expected);
+  for (std::int32_t i = 0; i < 50; ++i)
+  {
+    copy.remove(i);
+    expected.erase(i);
+  }
+  thenMapContainsItems(copy, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTreeifiedChainShrunkBetweenThresholds_WhenAddingKeys_ThenTheyAreFoundOnce)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash> map;
+  for (std::int32_t i = 0; i < 8; ++i)
+    map[i] = i;
+  map.remove(0);
+  map.remove(1);
+
+  map[100] = 100;
+  BOOST_REQUIRE(map.find(100) != map.end());
+  map[100] = 101;
+  map[101] = 101;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 8u);
+  BOOST_CHECK_EQUAL(map.valueOf(100), 101);
+  BOOST_CHECK_EQUAL(map.valueOf(101), 101);
+  for (std::int32_t i = 2; i < 8; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i), i);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBloomFilter_WhenLookingUpMissingKeys_ThenChainsAreRarelyScanned)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, CountingEqual> map;
+  map.setBloomFilter(true);
+  for (std::int32_t i = 0; i < 10000; ++i)
+    map[i * 2] = i;
+  CountingEqual::calls = 0;
+
+  for (std::int32_t i = 0; i < 10000; ++i)
+    BOOST_REQUIRE(map.find(i * 2 + 1) == map.end());
+
+  // scanning every chain would compare about as many keys as there are lookups
+  BOOST_CHECK(map.hasBloomFilter());
+  BOOST_CHECK_LT(CountingEqual::calls, 500);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBloomFilter_WhenRemovingMostItems_ThenFilterIsRebuilt)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, CountingEqual> map;
+  map.setBloomFilter(true);
+  for (std::int32_t i = 0; i < 10000; ++i)
+    map[i] = i;
+  for (std::int32_t i = 0; i < 9900; ++i)
+    map.remove(i);
+  CountingEqual::calls = 0;
+
+  for (std::int32_t i = 0; i < 9900; ++i)
+    BOOST_REQUIRE(map.find(i) == map.end());
+
+  BOOST_CHECK_LT(CountingEqual::calls, 500);
+  for (std::int32_t i = 9900; i < 10000; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i), i);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBloomFilter_WhenChurningThroughBothRehashModes_ThenNoItemIsMissed)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+  map.setBloomFilter(true);
+
+  for (std::int32_t round = 0; round < 4; ++round)
+  {
+    map.setRehashMode(round % 2 == 0 ? aisdi::RehashMode::Incremental : aisdi::RehashMode::Immediate);
+    for (std::int32_t i = 0; i < 3000; ++i)
+    {
+      const std::int32_t key = (i * 7919 + round * 131) % 5000;
+      if (i % 3 == 2 && expected.count(key) != 0)
+      {
+        map.remove(key);
+        expected.erase(key);
+      }
+      else
+      {
+        map[key] = i;
+        expected[key] = i;
+      }
+    }
+    thenMapContainsItems(map, expected);
+  }
+
+  auto copy = map;
+  thenMapContainsItems(copy, expected);
+  Map moved(std::move(copy));
+  moved[-1] = -1;
+  expected[-1] = -1;
+  thenMapContainsItems(moved, expected);
+
+  map.setBloomFilter(false);
+  BOOST_CHECK(!map.hasBloomFilter());
+  BOOST_CHECK(map.find(-1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenExtractingNodes_ThenTheyCanBeInsertedIntoAnotherMap)
+{
+  Map source = { { 1, 10 }, { 2, 20 }, { 3, 30 } };
+  Map target = { { 3, 300 } };
+
+  auto node = source.extract(1);
+  BOOST_REQUIRE(!node.empty());
+  BOOST_CHECK_EQUAL(node.key(), 1);
+  node.mapped() = 11;
+  BOOST_CHECK(source.extract(1).empty());
+  BOOST_CHECK_THROW(source.extract(source.end()), std::out_of_range);
+
+  auto inserted = target.insert(std::move(node));
+  BOOST_CHECK(inserted.inserted);
+  BOOST_CHECK(inserted.node.empty());
+  BOOST_CHECK_EQUAL(inserted.position->second, 11);
+
+  auto duplicate = target.insert(source.extract(source.find(3)));
+  BOOST_CHECK(!duplicate.inserted);
+  BOOST_CHECK_EQUAL(duplicate.position->second, 300);
+  BOOST_REQUIRE(duplicate.node);
+  BOOST_CHECK_EQUAL(duplicate.node.mapped(), 30);
+
+  BOOST_CHECK(!target.insert(Map::node_type()).inserted);
+  thenMapContainsItems(source, { { 2, 20 } });
+  thenMapContainsItems(target, { { 1, 11 }, { 3, 300 } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingAndTreeifiedMaps_WhenMerging_ThenOnlyNewKeysAreMoved)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash> source, target;
+  std::map<std::int32_t, std::int32_t> expectedSource, expectedTarget;
+  source.setRehashMode(aisdi::RehashMode::Incremental);
+  target.setRehashMode(aisdi::RehashMode::Incremental);
+  target.setBloomFilter(true);
+  for (std::int32_t i = 0; i < 500; ++i)
+  {
+    source[i] = i;
+    if (i % 5 == 0)
+      expectedSource[i] = i;
+    else
+      expectedTarget[i] = i;
+  }
+  for (std::int32_t i = 0; i < 500; i += 5)
+  {
+    target[i] = -i;
+    expectedTarget[i] = -i;
+  }
+  for (std::int32_t i = 500; i < 600; ++i)
+  {
+    target[i] = i;
+    expectedTarget[i] = i;
+  }
+
+  target.merge(source);
+  target.merge(target);
+
+  thenMapContainsItems(source, expectedSource);
+  thenMapContainsItems(target, expectedTarget);
+}
+
+BOOST_AUTO_TEST_CASE(GivenReservedTarget_WhenMergingOrMovingNodes_ThenNothingIsAllocated)
+{
+  using CountingMap = aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, std::equal_to<std::int32_t>,
+                                     aisdi::PowerOfTwoIndexing, true,
+                                     CountingAllocator<std::pair<std::int32_t, std::int32_t>>>;
+  CountingMap source, target;
+  for (std::int32_t i = 0; i < 100000; ++i)
+    source[i] = i;
+  target.reserve(100000);
+  allocationsCount = 0;
+
+  target.merge(source);
+  for (std::int32_t i = 0; i < 1000; ++i)
+    source.insert(target.extract(i));
+
+  BOOST_CHECK_EQUAL(allocationsCount, 0u);
+  BOOST_CHECK_EQUAL(source.getSize(), 1000u);
+  BOOST_CHECK_EQUAL(target.getSize(), 99000u);
+  BOOST_CHECK_EQUAL(target.valueOf(99999), 99999);
+  BOOST_CHECK_EQUAL(source.valueOf(999), 999);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMapWithLongChains_WhenErasingIf_ThenMatchingItemsAreGone)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, CollidingHash> colliding;
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  map.setBloomFilter(true);
+  fillUntilRehashing(map, expected, 1000);
+  for (auto& item : expected)
+    colliding[item.first] = item.second;
+
+  auto isMultipleOfThree = [](const std::pair<std::int32_t, std::int32_t>& item) { return item.first % 3 == 0; };
+  const auto removed = map.erase_if(isMultipleOfThree);
+  BOOST_CHECK_EQUAL(colliding.erase_if(isMultipleOfThree), removed);
+
+  std::size_t expectedRemoved = 0;
+  for (auto it = expected.begin(); it != expected.end();)
+  {
+    if (it->first % 3 == 0)
+    {
+      it = expected.erase(it);
+      ++expectedRemoved;
+    }
+    else
+      ++it;
+  }
+  BOOST_CHECK_EQUAL(removed, expectedRemoved);
+  thenMapContainsItems(map, expected);
+  thenMapContainsItems(colliding, expected);
+  for (std::int32_t i = 0; i < 1000; i += 3)
+    BOOST_CHECK(map.find(i) == map.end());
+
+  BOOST_CHECK_EQUAL(map.erase_if([](const std::pair<std::int32_t, std::int32_t>&) { return true; }), expected.size());
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenErasingWhileIterating_ThenEveryItemIsVisitedOnce)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  fillUntilRehashing(map, expected, 500);
+  BOOST_REQUIRE(map.isRehashing());
+  const auto initialSize = map.getSize();
+
+  std::size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++visited)
+  {
+    if (it->first % 2 == 1)
+    {
+      expected.erase(it->first);
+      it = map.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  BOOST_CHECK_EQUAL(visited, initialSize);
+  BOOST_CHECK(map.isRehashing());
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK_THROW(map.erase(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRangeWithDuplicates_WhenInsertingIt_ThenFirstOccurrenceWinsAndTableGrowsOnce)
+{
+  Map map = { { 1, -1 } };
+  std::vector<std::pair<std::int32_t, std::int32_t>> items;
+  std::map<std::int32_t, std::int32_t> expected = { { 1, -1 } };
+  for (std::int32_t i = 0; i < 5000; ++i)
+  {
+    items.emplace_back(i % 4000, i);
+    expected.emplace(i % 4000, i);
+  }
+
+  map.insert(items.begin(), items.end());
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK_EQUAL(map.bucket_count(), aisdi::PowerOfTwoIndexing::bucketCount(5001));
+
+  Map copy;
+  copy.insert(expected.begin(), expected.end());
+  thenMapContainsItems(copy, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStatefulHash_WhenCopyingMap_ThenHashIsCopiedAlong)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, SeededHash> map(SeededHash{ 12345 });
+  for (std::int32_t i = 0; i < 100; ++i)
+    map[i] = i;
+
+  auto other = map;
+  other[100] = 100;
+
+  BOOST_CHECK_EQUAL(other.getSize(), 101);
+  BOOST_CHECK_EQUAL(other.valueOf(50), 50);
+  BOOST_CHECK_EQUAL(map.valueOf(50), 50);
+}
+
+BOOST_AUTO_TEST_CASE(GivenReservedMap_WhenAddingReservedNumberOfItems_ThenMapIsNotRehashed)
+{
+  for (auto mode : { aisdi::RehashMode::Immediate, aisdi::RehashMode::Incremental })
+  {
+    Map map;
+    map.setRehashMode(mode);
+    map.reserve(20000);
+    const auto buckets = map.bucket_count();
+    BOOST_CHECK_GE(buckets * map.max_load_factor(), 20000);
+
+    std::map<std::int32_t, std::int32_t> expected;
+    for (std::int32_t i = 0; i < 20000; ++i)
+    {
+      map[i] = i;
+      expected[i] = i;
+    }
+
+    BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+    BOOST_CHECK(!map.isRehashing());
+    thenMapContainsItems(map, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenReservedMap_WhenReservingLess_ThenTableIsNotShrunk)
+{
+  Map map;
+  map.reserve(1000);
+  const auto buckets = map.bucket_count();
+
+  map.reserve(10);
+
+  BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInitializerList_WhenCreatingMap_ThenTableFitsAllItems)
+{
+  const Map map = { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 }, { 6, 6 }, { 7, 7 }, { 8, 8 }, { 9, 9 } };
+
+  BOOST_CHECK_LE(map.load_factor(), map.max_load_factor());
+  BOOST_CHECK_EQUAL(map.getSize(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInitializerListWithDuplicateKeys_WhenCreatingMap_ThenFirstOccurrenceIsStoredOnce)
+{
+  const Map map = { { 1, 1 }, { 2, 2 }, { 1, 3 } };
+
+  thenMapContainsItems(map, { { 1, 1 }, { 2, 2 } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenDuplicateKeys_WhenBuildingFromListOrInsertingRange_ThenBothKeepTheFirst)
+{
+  const std::vector<std::pair<std::int32_t, std::int32_t>> items = { { 1, 1 }, { 2, 2 }, { 1, 3 }, { 2, 4 } };
+  const Map fromList = { { 1, 1 }, { 2, 2 }, { 1, 3 }, { 2, 4 } };
+  Map fromRange;
+  fromRange.insert(items.begin(), items.end());
+
+  thenMapContainsItems(fromList, { { 1, 1 }, { 2, 2 } });
+  thenMapContainsItems(fromRange, { { 1, 1 }, { 2, 2 } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenLowerMaxLoadFactor_WhenAddingItems_ThenLoadFactorStaysBelowIt)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 100; ++i)
+    map[i] = i;
+
+  map.max_load_factor(0.25f);
+  BOOST_CHECK_LE(map.load_factor(), 0.25f);
+
+  for (std::int32_t i = 100; i < 1000; ++i)
+  {
+    map[i] = i;
+    BOOST_REQUIRE_LE(map.load_factor(), 0.25f);
+  }
+  BOOST_CHECK_EQUAL(map.getSize(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonPositiveMaxLoadFactor_WhenSettingIt_ThenExceptionIsThrown)
+{
+  Map map;
+  BOOST_CHECK_THROW(map.max_load_factor(0.0f), std::invalid_argument);
+  BOOST_CHECK_THROW(map.max_load_factor(-1.0f), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilledMap_WhenRehashing_ThenAllItemsAreInMap,
+                              Policy,
+                              IndexPolicies)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, std::equal_to<std::int32_t>, Policy> map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 500; ++i)
+  {
+    map[i] = i;
+    expected[i] = i;
+  }
+
+  map.rehash(3000);
+  BOOST_CHECK_GE(map.bucket_count(), 3000);
+  BOOST_CHECK(!map.isRehashing());
+  thenMapContainsItems(map, expected);
+
+  map.rehash(0);
+  BOOST_CHECK_LT(map.bucket_count(), 3000);
+  BOOST_CHECK_LE(map.load_factor(), map.max_load_factor());
+  thenMapContainsItems(map, expected);
+
+  for (std::int32_t i = 500; i < 1000; ++i)
+  {
+    map[i] = i;
+    expected[i] = i;
+  }
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompactMap_WhenMigratingAndRemoving_ThenAllItemsAreInMap)
+{
+  aisdi::CompactHashMap<std::int32_t, std::int32_t> map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t i = 0; i < 5000; ++i)
+  {
+    map[i] = i;
+    expected[i] = i;
+  }
+  for (std::int32_t i = 0; i < 5000; i += 3)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+  thenMapContainsItems(map, expected);
+
+  auto copy = map;
+  copy.rehash(0);
+  thenMapContainsItems(copy, expected);
+
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+  BOOST_CHECK_EQUAL(visited, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompactMapWithCollidingHash_WhenRemovingFromTheMiddleOfChain_ThenOtherItemsStay)
+{
+  aisdi::CompactHashMap<std::int32_t, std::int32_t, CollidingHash> map;
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 50; ++i)
+  {
+    map[i] = i;
+    expected[i] = i;
+  }
+  for (std::int32_t i = 10; i < 40; ++i)
+  {
+    map.remove(map.find(i));
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoolAllocator_WhenFreeingAndAllocating_ThenBlocksAreReused)
+{
+  aisdi::PoolAllocator<std::pair<std::int64_t, std::int64_t>> allocator;
+  auto first = allocator.allocate(1);
+  allocator.deallocate(first, 1);
+
+  auto second = allocator.allocate(1);
+  BOOST_CHECK_EQUAL(first, second);
+  allocator.deallocate(second, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompactMapsOnSeveralThreads_WhenModifyingThemAtOnce_ThenEachKeepsItsItems)
+{
+  using CompactMap = aisdi::CompactHashMap<std::int32_t, std::int32_t>;
+  std::vector<CompactMap> maps(4);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < maps.size(); ++t)
+  {
+    threads.emplace_back([&maps, t] {
+      auto& map = maps[t];
+      for (std::int32_t round = 0; round < 20; ++round)
+      {
+        for (std::int32_t i = 0; i < 2000; ++i)
+          map[i] = i + round;
+        for (std::int32_t i = 0; i < 2000; i += 2)
+          map.remove(i);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 1; i < 2000; i += 2)
+    expected[i] = i + 19;
+  for (auto& map : maps)
+    thenMapContainsItems(map, expected);
+
+  // nodes allocated by the threads that exited are freed by this one
+  maps.clear();
+  CompactMap map;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+  BOOST_CHECK_EQUAL(map.getSize(), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPooledListMap_WhenReplacingItems_ThenAllItemsAreInMap)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>, std::equal_to<std::int32_t>,
+                 aisdi::PowerOfTwoIndexing, false, aisdi::PoolAllocator<std::pair<std::int32_t, std::int32_t>>> map;
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+  for (std::int32_t i = 0; i < 1000; ++i)
+  {
+    map.remove(i);
+    map[i + 1000] = i;
+    expected[i + 1000] = i;
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMigratingMap_WhenFindingManyKeys_ThenEachKeyIsResolvedInOrder)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+
+  std::vector<std::int32_t> keys;
+  for (std::int32_t i = -50; i < static_cast<std::int32_t>(expected.size()) + 50; ++i)
+    keys.push_back(i * 7 % 500);
+  std::vector<Map::const_iterator> found;
+
+  const Map& constMap = map;
+  constMap.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+
+  BOOST_REQUIRE_EQUAL(found.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i)
+  {
+    if (expected.count(keys[i]) == 0)
+      BOOST_CHECK(found[i] == map.end());
+    else
+      BOOST_CHECK(found[i] == map.find(keys[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompactMap_WhenFindingManyKeys_ThenValuesCanBeModified)
+{
+  aisdi::CompactHashMap<std::int32_t, std::int32_t> map;
+  for (std::int32_t i = 0; i < 100; ++i)
+    map[i] = i;
+
+  const std::vector<std::int32_t> keys = { 5, 500, 17, 99 };
+  std::vector<aisdi::CompactHashMap<std::int32_t, std::int32_t>::iterator> found(keys.size());
+  map.findMany(keys.begin(), keys.end(), found.begin());
+
+  BOOST_CHECK(found[1] == map.end());
+  found[0]->second = -5;
+  found[3]->second = -99;
+  BOOST_CHECK_EQUAL(map.valueOf(5), -5);
+  BOOST_CHECK_EQUAL(map.valueOf(99), -99);
+  BOOST_CHECK_EQUAL(found[2]->second, 17);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenFindingManyKeys_ThenAllAreMissing)
+{
+  const Map map;
+  const std::vector<std::int32_t> keys(40, 1);
+  std::vector<Map::const_iterator> found;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+
+  BOOST_REQUIRE_EQUAL(found.size(), keys.size());
+  for (auto& it : found)
+    BOOST_CHECK(it == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringHash_WhenHashingCStringAndString_ThenHashesAreEqual)
+{
+  aisdi::StringHash hash;
+  BOOST_CHECK_EQUAL(hash("Alice"), hash(std::string("Alice")));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTransparentHashAndEquality_WhenUsingCStringKeys_ThenItemsAreFoundAndRemoved)
+{
+  aisdi::HashMap<std::string, std::int32_t, aisdi::StringHash, std::equal_to<>> map;
+  map["Alice"] = 1;
+  map["Bob"] = 2;
+  map["Chuck"] = 3;
+
+  const char* bob = "Bob";
+  BOOST_CHECK_EQUAL(map.valueOf(bob), 2);
+  BOOST_CHECK_EQUAL(map.find("Alice")->second, 1);
+  BOOST_CHECK(map.find("Dave") == map.end());
+  BOOST_CHECK_THROW(map.valueOf("Dave"), std::out_of_range);
+
+  map.remove("Chuck");
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_THROW(map.remove("Chuck"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSparseMap_WhenIteratingBothWays_ThenOnlyRemainingItemsAreVisited)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 10000; ++i)
+    map[i] = i;
+  for (std::int32_t i = 0; i < 10000; ++i)
+  {
+    if (i % 997 == 5)
+      expected[i] = i;
+    else
+      map.remove(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+  BOOST_CHECK_EQUAL(visited, expected.size());
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDefaultConstructedIterators_WhenComparing_ThenOnlyTheyAreEqual)
+{
+  Map map = { { 1, 1 } };
+  const Map::const_iterator none;
+  const Map::iterator other;
+
+  BOOST_CHECK(none == Map::const_iterator());
+  BOOST_CHECK(none == other);
+  BOOST_CHECK(none != map.begin());
+  BOOST_CHECK(map.end() != none);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenRemovingFirstItemsOneByOne_ThenBeginFollowsThem)
+{
+  Map map;
+  map.setRehashMode(aisdi::RehashMode::Incremental);
+  std::map<std::int32_t, std::int32_t> expected;
+  fillUntilRehashing(map, expected, 100);
+
+  while (!map.isEmpty())
+  {
+    auto first = map.begin();
+    BOOST_REQUIRE(expected.count(first->first) == 1);
+    expected.erase(first->first);
+    map.remove(first);
+    std::size_t visited = 0;
+    for (auto it = map.begin(); it != map.end(); ++it)
+      ++visited;
+    BOOST_REQUIRE_EQUAL(visited, expected.size());
+  }
+  BOOST_CHECK(map.begin() == map.end());
+
+  map[7] = 7;
+  BOOST_CHECK_EQUAL(map.begin()->first, 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
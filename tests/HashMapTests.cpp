@@ -1,9 +1,13 @@
 #include "../src/HashMap.h"
+#include "../src/SwissHashMap.h"
+#include "../src/RobinHoodHashMap.h"
+#include "../src/DenseHashMap.h"
 
 #include <cstdint>
 #include <string>
 #include <map>
 #include <functional>
+#include <memory>
 
 #include <boost/test/unit_test.hpp>
 
@@ -139,8 +143,13 @@ struct Fixture
 
 } // namespace
 
+// The same suite is built for every hash map engine, see tests/CMakeLists.txt.
+#ifndef AISDI_TESTED_HASH_MAP
+#define AISDI_TESTED_HASH_MAP HashMap
+#endif
+
 template <typename K>
-using Map = aisdi::HashMap<K, std::string>;
+using Map = aisdi::AISDI_TESTED_HASH_MAP<K, std::string>;
 
 using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t, OperationCountingObject>;
 
@@ -802,6 +811,125 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingItemWithRvalueKey_ThenKeyIsNotCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  K key = 42;
+
+  OperationCountingObject::resetCounters();
+  map[std::move(key)] = "Alice";
+
+  thenCopiedObjectsCountWas<K>(0);
+  thenMapContainsItems(map, { { 42, "Alice" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenTryEmplacingManyItems_ThenNoKeyIsCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 100; ++i)
+    expected[i] = std::to_string(i);
+
+  OperationCountingObject::resetCounters();
+  for (int i = 0; i < 100; ++i)
+  {
+    auto result = map.try_emplace(K(i), std::to_string(i));
+    BOOST_REQUIRE(result.second);
+    BOOST_REQUIRE_EQUAL(result.first->first, K(i));
+  }
+
+  thenCopiedObjectsCountWas<K>(0);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenTryEmplacingExistingKey_ThenArgumentsAreNotConsumed,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+  std::string value = "Bob";
+
+  auto result = map.try_emplace(42, std::move(value));
+
+  BOOST_CHECK(!result.second);
+  BOOST_CHECK_EQUAL(result.first->second, "Alice");
+  BOOST_CHECK_EQUAL(value, "Bob");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenValueFromTheMap_WhenTryEmplacingAcrossGrowth_ThenValueIsCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const std::string value(40, 'x');
+  map[K(0)] = value;
+
+  for (int i = 1; i < 1000; ++i)
+    map.try_emplace(K(i), map.valueOf(K(0)));
+
+  for (int i = 0; i < 1000; ++i)
+    BOOST_REQUIRE_EQUAL(map.valueOf(K(i)), value);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenInsertingOrAssigning_ThenValuesAreReplacedOrAdded,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  auto assigned = map.insert_or_assign(42, "Bob");
+  auto inserted = map.insert_or_assign(K(27), std::string("Chuck"));
+
+  BOOST_CHECK(!assigned.second);
+  BOOST_CHECK(inserted.second);
+  BOOST_CHECK_EQUAL(inserted.first->second, "Chuck");
+  thenMapContainsItems(map, { { 42, "Bob" }, { 27, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenEmplacing_ThenOnlyNewKeysAreAdded,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  BOOST_CHECK(!map.emplace(42, "Bob").second);
+  BOOST_CHECK(map.emplace(27, "Chuck").second);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenInitializerListWithDuplicateKeys_WhenCreatingMap_ThenFirstValueIsKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Chuck" }, { 42, "Bob" } };
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMoveOnlyValues_WhenAddingAndRemovingItems_ThenValuesAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::AISDI_TESTED_HASH_MAP<K, std::unique_ptr<int>> map;
+  for (int i = 0; i < 100; ++i)
+    map.try_emplace(K(i), new int(i));
+  for (int i = 100; i < 200; ++i)
+    map[K(i)] = std::unique_ptr<int>(new int(i));
+  map.insert_or_assign(K(0), std::unique_ptr<int>(new int(-1)));
+  for (int i = 1; i < 200; i += 2)
+    map.remove(K(i));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 100);
+  BOOST_CHECK_EQUAL(*map.valueOf(K(0)), -1);
+  for (int i = 2; i < 200; i += 2)
+    BOOST_REQUIRE_EQUAL(*map.valueOf(K(i)), i);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,127 @@
+#include "../src/HashSet.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using Set = aisdi::HashSet<std::int32_t>;
+
+namespace
+{
+
+void thenSetContainsKeys(const Set& set, const std::set<std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(set.getSize(), expected.size());
+
+  std::size_t iterated = 0;
+  for (auto key : set)
+  {
+    BOOST_REQUIRE_MESSAGE(expected.count(key) == 1, "Unexpected key: " << key);
+    ++iterated;
+  }
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+
+  for (auto key : expected)
+    BOOST_CHECK_MESSAGE(set.contains(key), "Missing required key: " << key);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HashSetTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptySet_WhenInsertingKeys_ThenEachIsStoredOnce)
+{
+  Set set;
+  BOOST_CHECK(set.isEmpty());
+
+  BOOST_CHECK(set.insert(1).second);
+  BOOST_CHECK(set.insert(2).second);
+  auto again = set.insert(1);
+
+  BOOST_CHECK(!again.second);
+  BOOST_CHECK_EQUAL(*again.first, 1);
+  thenSetContainsKeys(set, { 1, 2 });
+  BOOST_CHECK(!set.contains(3));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSet_WhenRemovingKeys_ThenTheyAreGoneAndMissingOnesThrow)
+{
+  Set set = { 1, 2, 3, 4 };
+
+  set.remove(2);
+  set.remove(set.find(3));
+
+  thenSetContainsKeys(set, { 1, 4 });
+  BOOST_CHECK(set.find(2) == set.end());
+  BOOST_CHECK_THROW(set.remove(2), std::out_of_range);
+  BOOST_CHECK_THROW(set.remove(set.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRangesWithDuplicates_WhenInsertingThem_ThenDuplicatesAreSkipped)
+{
+  std::vector<std::int32_t> keys;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    keys.push_back(i % 300);
+
+  Set set(keys.begin(), keys.end());
+  std::set<std::int32_t> expected(keys.begin(), keys.end());
+  thenSetContainsKeys(set, expected);
+
+  Set copy(set.begin(), set.end());
+  BOOST_CHECK(copy == set);
+  copy.insert(1000);
+  BOOST_CHECK(copy != set);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoSets_WhenCombiningThem_ThenResultsMatchStdAlgorithms)
+{
+  Set first, second;
+  std::set<std::int32_t> expectedFirst, expectedSecond;
+  for (std::int32_t i = 0; i < 2000; ++i)
+  {
+    first.insert(i * 3);
+    expectedFirst.insert(i * 3);
+  }
+  for (std::int32_t i = 0; i < 500; ++i)
+  {
+    second.insert(i * 4);
+    expectedSecond.insert(i * 4);
+  }
+
+  std::set<std::int32_t> expectedUnion, expectedIntersection, expectedDifference, expectedReverseDifference;
+  std::set_union(expectedFirst.begin(), expectedFirst.end(), expectedSecond.begin(), expectedSecond.end(),
+                 std::inserter(expectedUnion, expectedUnion.end()));
+  std::set_intersection(expectedFirst.begin(), expectedFirst.end(), expectedSecond.begin(), expectedSecond.end(),
+                        std::inserter(expectedIntersection, expectedIntersection.end()));
+  std::set_difference(expectedFirst.begin(), expectedFirst.end(), expectedSecond.begin(), expectedSecond.end(),
+                      std::inserter(expectedDifference, expectedDifference.end()));
+  std::set_difference(expectedSecond.begin(), expectedSecond.end(), expectedFirst.begin(), expectedFirst.end(),
+                      std::inserter(expectedReverseDifference, expectedReverseDifference.end()));
+
+  thenSetContainsKeys(unionOf(first, second), expectedUnion);
+  thenSetContainsKeys(unionOf(second, first), expectedUnion);
+  thenSetContainsKeys(intersectionOf(first, second), expectedIntersection);
+  thenSetContainsKeys(intersectionOf(second, first), expectedIntersection);
+  thenSetContainsKeys(differenceOf(first, second), expectedDifference);
+  thenSetContainsKeys(differenceOf(second, first), expectedReverseDifference);
+  thenSetContainsKeys(differenceOf(first, first), {});
+}
+
+BOOST_AUTO_TEST_CASE(GivenKeysOnlySet_WhenComparingNodeSize_ThenItIsNoBiggerThanMapOfBool)
+{
+  using LongKeys = aisdi::HashSet<std::uint64_t>;
+  using LongKeysMap = aisdi::HashMap<std::uint64_t, bool>;
+
+  BOOST_CHECK_LT(sizeof(LongKeys::map_type::entry_type), sizeof(LongKeysMap::entry_type));
+  BOOST_CHECK_LE(sizeof(Set::map_type::entry_type), sizeof(aisdi::HashMap<std::int32_t, bool>::entry_type));
+
+  aisdi::HashSet<std::string> strings = { "a", "b" };
+  BOOST_CHECK(strings.contains("a"));
+  BOOST_CHECK_EQUAL(sizeof(decltype(strings)::map_type::entry_type), sizeof(std::string));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
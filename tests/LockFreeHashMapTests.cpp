@@ -0,0 +1,198 @@
+#include "../src/LockFreeHashMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+using Map = aisdi::LockFreeHashMap<std::int32_t, std::int32_t>;
+
+template <typename Function>
+void runInThreads(std::size_t threadsCount, Function function)
+{
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadsCount; ++i)
+    threads.emplace_back(function, i);
+  for (auto& thread : threads)
+    thread.join();
+}
+
+const std::size_t threadsCount = 8;
+
+struct CollidingHash
+{
+  std::size_t operator()(std::int32_t) const
+  {
+    return 42;
+  }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LockFreeHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenInsertingItem_ThenItCanBeFound)
+{
+  Map map;
+  BOOST_CHECK(map.isEmpty());
+
+  BOOST_CHECK(map.insert(42, 1));
+
+  BOOST_CHECK(map.contains(42));
+  BOOST_CHECK_EQUAL(map.valueOf(42), 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptyMap_WhenInsertingExistingKey_ThenValueIsKept)
+{
+  Map map;
+  map.insert(42, 1);
+
+  BOOST_CHECK(!map.insert(42, 2));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingKey_WhenReadingOrRemoving_ThenItIsReported)
+{
+  Map map;
+  map.insert(1, 1);
+  std::int32_t value = 0;
+
+  BOOST_CHECK(!map.find(2, value));
+  BOOST_CHECK_THROW(map.valueOf(2), std::out_of_range);
+  BOOST_CHECK(!map.remove(2));
+  BOOST_CHECK(map.remove(1));
+  BOOST_CHECK(!map.remove(1));
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyItems_WhenGrowing_ThenBucketsDoubleAndAllItemsAreFound)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 50000; ++i)
+    map.insert(i, -i);
+  for (std::int32_t i = 0; i < 50000; i += 3)
+    map.remove(i);
+
+  BOOST_CHECK_GE(map.bucketCount(), 50000 / 2);
+  BOOST_CHECK_EQUAL(map.bucketCount() & (map.bucketCount() - 1), 0);
+  for (std::int32_t i = 0; i < 50000; ++i)
+  {
+    std::int32_t value = 0;
+    BOOST_REQUIRE_EQUAL(map.find(i, value), i % 3 != 0);
+    if (i % 3 != 0)
+      BOOST_REQUIRE_EQUAL(value, -i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenCollidingHash_WhenAddingAndRemovingItems_ThenKeysAreToldApart)
+{
+  aisdi::LockFreeHashMap<std::int32_t, std::string, CollidingHash> map;
+  for (std::int32_t i = 0; i < 100; ++i)
+    map.insert(i, std::to_string(i));
+  for (std::int32_t i = 0; i < 100; i += 2)
+    map.remove(i);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 50);
+  BOOST_CHECK(!map.contains(10));
+  BOOST_CHECK_EQUAL(map.valueOf(11), "11");
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenInsertingDisjointKeys_ThenAllItemsAreFound)
+{
+  Map map;
+
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    for (std::int32_t i = 0; i < 20000; ++i)
+      map.insert(static_cast<std::int32_t>(i * threadsCount + thread), i);
+  });
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadsCount * 20000);
+  for (std::int32_t key = 0; key < static_cast<std::int32_t>(threadsCount * 20000); ++key)
+    BOOST_REQUIRE_EQUAL(map.valueOf(key), key / static_cast<std::int32_t>(threadsCount));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenInsertingSameKeys_ThenEachKeyIsInsertedOnce)
+{
+  Map map;
+  std::atomic<std::size_t> inserted(0);
+
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    for (std::int32_t i = 0; i < 10000; ++i)
+      inserted += map.insert(i, static_cast<std::int32_t>(thread));
+  });
+
+  BOOST_CHECK_EQUAL(inserted.load(), 10000);
+  BOOST_CHECK_EQUAL(map.getSize(), 10000);
+}
+
+// Writers keep inserting and removing their own keys while readers look for
+// keys that are never removed; readers must see every one of them every time.
+BOOST_AUTO_TEST_CASE(GivenWritersChurning_WhenReadingStableKeys_ThenTheyAreAlwaysFound)
+{
+  Map map;
+  const std::int32_t stableKeys = 1000;
+  for (std::int32_t i = 0; i < stableKeys; ++i)
+    map.insert(-i - 1, i);
+
+  std::atomic<std::size_t> missing(0), wrongValues(0), removedTwice(0);
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    if (thread % 2 == 0)
+    {
+      const auto base = static_cast<std::int32_t>(thread * 1000000);
+      for (std::int32_t round = 0; round < 20; ++round)
+      {
+        for (std::int32_t i = 0; i < 2000; ++i)
+          map.insert(base + i, i);
+        for (std::int32_t i = 0; i < 2000; ++i)
+          removedTwice += !map.remove(base + i);
+      }
+    }
+    else
+    {
+      for (std::int32_t round = 0; round < 40; ++round)
+      {
+        for (std::int32_t i = 0; i < stableKeys; ++i)
+        {
+          std::int32_t value = 0;
+          if (!map.find(-i - 1, value))
+            ++missing;
+          else if (value != i)
+            ++wrongValues;
+        }
+      }
+    }
+  });
+
+  BOOST_CHECK_EQUAL(missing.load(), 0);
+  BOOST_CHECK_EQUAL(wrongValues.load(), 0);
+  BOOST_CHECK_EQUAL(removedTwice.load(), 0);
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(stableKeys));
+}
+
+// Every thread races to remove the same keys; each key is removed exactly once.
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenRemovingSameKeys_ThenEachKeyIsRemovedOnce)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 20000; ++i)
+    map.insert(i, i);
+  std::atomic<std::size_t> removed(0);
+
+  runInThreads(threadsCount, [&](std::size_t) {
+    for (std::int32_t i = 0; i < 20000; ++i)
+      removed += map.remove(i);
+  });
+
+  BOOST_CHECK_EQUAL(removed.load(), 20000);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+#include "../src/HashMap.h"
+#include "../src/MappedHashMap.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+struct Point
+{
+  std::int32_t x;
+  std::int32_t y;
+};
+
+struct PointHash
+{
+  std::size_t operator()(const Point& point) const
+  {
+    return std::hash<std::int64_t>()((std::int64_t(point.x) << 32) | std::uint32_t(point.y));
+  }
+};
+
+struct PointEqual
+{
+  bool operator()(const Point& lhs, const Point& rhs) const
+  {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+  }
+};
+
+struct ShiftedHash
+{
+  std::size_t operator()(std::int32_t key) const
+  {
+    return std::hash<std::int32_t>()(key + 1);
+  }
+};
+
+struct FlatFileFixture
+{
+  FlatFileFixture() : path("aisdiMappedHashMapTests." + std::to_string(::getpid()))
+  {
+  }
+
+  ~FlatFileFixture()
+  {
+    std::remove(path.c_str());
+  }
+
+  std::string path;
+};
+
+std::size_t countFilesStartingWith(const std::string& prefix)
+{
+  std::size_t count = 0;
+  DIR* directory = ::opendir(".");
+  BOOST_REQUIRE(directory != nullptr);
+  while (dirent* entry = ::readdir(directory))
+    count += std::string(entry->d_name).compare(0, prefix.size(), prefix) == 0;
+  ::closedir(directory);
+  return count;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(MappedHashMapTests, FlatFileFixture)
+
+BOOST_AUTO_TEST_CASE(GivenSavedMap_WhenMappingIt_ThenEveryItemIsFound)
+{
+  aisdi::HashMap<std::int64_t, double> map;
+  std::map<std::int64_t, double> expected;
+  for (std::int64_t i = 0; i < 5000; ++i)
+  {
+    map[i * 7919] = i / 2.0;
+    expected[i * 7919] = i / 2.0;
+  }
+
+  aisdi::saveFlat(map, path);
+  aisdi::MappedHashMap<std::int64_t, double> mapped(path);
+
+  BOOST_CHECK_EQUAL(mapped.getSize(), expected.size());
+  for (auto& item : expected)
+  {
+    auto it = mapped.find(item.first);
+    BOOST_REQUIRE(it != mapped.end());
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(mapped.valueOf(item.first), item.second);
+  }
+  BOOST_CHECK(!mapped.contains(1));
+  BOOST_CHECK(mapped.find(-7919) == mapped.end());
+  BOOST_CHECK_THROW(mapped.valueOf(1), std::out_of_range);
+
+  std::map<std::int64_t, double> iterated;
+  for (auto& item : mapped)
+    iterated[item.first] = item.second;
+  BOOST_CHECK(iterated == expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenSavingAndMapping_ThenViewIsEmpty)
+{
+  aisdi::saveFlat(aisdi::HashMap<std::int32_t, std::int32_t>(), path);
+  aisdi::MappedHashMap<std::int32_t, std::int32_t> mapped(path);
+
+  BOOST_CHECK(mapped.isEmpty());
+  BOOST_CHECK(mapped.begin() == mapped.end());
+  BOOST_CHECK(!mapped.contains(0));
+  BOOST_CHECK_THROW(*mapped.end(), std::out_of_range);
+  BOOST_CHECK_THROW(++mapped.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStructKeysWithCustomHash_WhenMapping_ThenTheyAreFound)
+{
+  aisdi::HashMap<Point, Point, PointHash, PointEqual> map;
+  for (std::int32_t i = 0; i < 100; ++i)
+    map[Point{ i, -i }] = Point{ -i, i };
+
+  aisdi::saveFlat(map, path);
+  aisdi::MappedHashMap<Point, Point, PointHash, PointEqual> mapped(path);
+
+  for (std::int32_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(mapped.valueOf(Point{ i, -i }).x, -i);
+  BOOST_CHECK(!mapped.contains(Point{ 1, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenFileOfOtherTypes_WhenMappingIt_ThenItIsRejected)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t> map = { { 1, 1 } };
+  aisdi::saveFlat(map, path);
+
+  using WrongValue = aisdi::MappedHashMap<std::int32_t, std::int64_t>;
+  using WrongHash = aisdi::MappedHashMap<std::int32_t, std::int32_t, ShiftedHash>;
+  BOOST_CHECK_THROW(WrongValue mapped(path), std::runtime_error);
+  BOOST_CHECK_THROW(WrongHash mapped(path), std::runtime_error);
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<std::int32_t, std::int32_t>(path + ".missing")), std::system_error);
+
+  std::ofstream(path) << "std::map<int, int>";
+  BOOST_CHECK_THROW((aisdi::MappedHashMap<std::int32_t, std::int32_t>(path)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMappedFile_WhenSavingOverIt_ThenOldViewKeepsOldItems)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t> map = { { 1, 10 }, { 2, 20 } };
+  aisdi::saveFlat(map, path);
+  aisdi::MappedHashMap<std::int32_t, std::int32_t> old(path);
+
+  map.remove(1);
+  map[3] = 30;
+  aisdi::saveFlat(map, path);
+  aisdi::MappedHashMap<std::int32_t, std::int32_t> current(path);
+
+  BOOST_CHECK_EQUAL(old.valueOf(1), 10);
+  BOOST_CHECK(!old.contains(3));
+  BOOST_CHECK(!current.contains(1));
+  BOOST_CHECK_EQUAL(current.valueOf(3), 30);
+  BOOST_CHECK_EQUAL(current.getSize(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSavesThatSucceedAndFail_WhenDone_ThenNoTemporaryFileIsLeft)
+{
+  aisdi::HashMap<std::int32_t, std::int32_t> map = { { 1, 10 }, { 2, 20 } };
+  aisdi::saveFlat(map, path);
+  aisdi::saveFlat(map, path);
+  BOOST_CHECK_THROW(aisdi::saveFlat(map, path + ".missing/file"), std::system_error);
+
+  aisdi::MappedHashMap<std::int32_t, std::int32_t> mapped(path);
+  BOOST_CHECK_EQUAL(countFilesStartingWith(path), 1u);
+  BOOST_CHECK_EQUAL(mapped.valueOf(2), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+#include "../src/RobinHoodHashMap.h"
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+// The generic map behaviour is covered by HashMapTests.cpp, which is also built
+// against RobinHoodHashMap. Here we only stress Robin Hood probing and
+// backward-shift removal.
+
+using Map = aisdi::RobinHoodHashMap<std::int32_t, std::int32_t>;
+
+namespace
+{
+
+void thenMapContainsItems(const Map& map, const std::map<std::int32_t, std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  std::size_t iterated = 0;
+  for (const auto& item : map)
+  {
+    auto it = expected.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != expected.end(), "Unexpected key: " << item.first);
+    BOOST_CHECK_EQUAL(item.second, it->second);
+    ++iterated;
+  }
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(map.find(item.first) != map.end(), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  }
+}
+
+// Value whose copies start throwing once copiesLeft runs out.
+class CopyLimitedValue
+{
+public:
+  explicit CopyLimitedValue(int value_) : value(value_)
+  {
+    ++alive;
+  }
+
+  CopyLimitedValue(const CopyLimitedValue& other) : value(other.value)
+  {
+    if (copiesLeft == 0)
+      throw std::runtime_error("Copy limit reached");
+    --copiesLeft;
+    ++alive;
+  }
+
+  ~CopyLimitedValue()
+  {
+    --alive;
+  }
+
+  CopyLimitedValue& operator=(const CopyLimitedValue&) = default;
+
+  int value;
+
+  static std::size_t copiesLeft;
+  static std::size_t alive;
+};
+
+std::size_t CopyLimitedValue::copiesLeft = static_cast<std::size_t>(-1);
+std::size_t CopyLimitedValue::alive = 0;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RobinHoodHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenAddingManyItems_ThenAllItemsAreInMap)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t i = 0; i < 5000; ++i)
+  {
+    map[i * 7] = i;
+    expected[i * 7] = i;
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenRemovingAndAddingRepeatedly_ThenContentIsConsistent)
+{
+  Map map;
+  std::map<std::int32_t, std::int32_t> expected;
+
+  for (std::int32_t round = 0; round < 20; ++round)
+  {
+    for (std::int32_t i = 0; i < 300; ++i)
+    {
+      map[round * 1000 + i] = i;
+      expected[round * 1000 + i] = i;
+    }
+    for (std::int32_t i = 0; i < 300; i += 2)
+    {
+      map.remove(round * 1000 + i);
+      expected.erase(round * 1000 + i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMapWithRemovedItems_WhenSearchingForThem_ThenEndIsReturned)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = i;
+
+  for (std::int32_t i = 0; i < 1000; i += 3)
+    map.remove(map.find(i));
+
+  for (std::int32_t i = 0; i < 1000; ++i)
+    BOOST_CHECK_EQUAL(map.find(i) == map.end(), i % 3 == 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeMap_WhenCopying_ThenCopiesAreEqualAndIndependent)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    map[i] = -i;
+
+  Map other(map);
+  BOOST_CHECK(other == map);
+
+  other.remove(10);
+  BOOST_CHECK(other != map);
+  BOOST_CHECK_EQUAL(map.valueOf(10), -10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenIterator_WhenWalkingBackwardsFromEnd_ThenEveryItemIsVisited)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 100; ++i)
+    map[i] = i;
+
+  std::size_t visited = 0;
+  for (auto it = map.end(); it != map.begin(); --it)
+    ++visited;
+
+  BOOST_CHECK_EQUAL(visited, 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCollidingCluster_WhenRemovingItsHead_ThenFollowingItemsAreStillFound)
+{
+  Map map;
+  for (std::int32_t i = 0; i < 7; ++i)
+    map[i] = i;
+
+  for (std::int32_t i = 0; i < 7; ++i)
+  {
+    map.remove(i);
+    for (std::int32_t j = i + 1; j < 7; ++j)
+      BOOST_CHECK_EQUAL(map.valueOf(j), j);
+  }
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenValueWhoseCopyThrows_WhenCopyingMap_ThenCopiedValuesAreDestroyed)
+{
+  {
+    using ValueMap = aisdi::RobinHoodHashMap<std::int32_t, CopyLimitedValue>;
+    ValueMap map;
+    for (std::int32_t i = 0; i < 100; ++i)
+      map.try_emplace(i, i);
+
+    CopyLimitedValue::copiesLeft = 50;
+    BOOST_CHECK_THROW(ValueMap copy(map), std::runtime_error);
+    CopyLimitedValue::copiesLeft = static_cast<std::size_t>(-1);
+    BOOST_CHECK_EQUAL(CopyLimitedValue::alive, 100u);
+  }
+  BOOST_CHECK_EQUAL(CopyLimitedValue::alive, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,252 @@
+#include "../src/SmallMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+std::size_t allocationsCount = 0;
+
+// Counts what a map takes from the system, so that a test can check it took nothing.
+template <typename T>
+struct CountingAllocator
+{
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&)
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    ++allocationsCount;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* pointer, std::size_t n)
+  {
+    std::allocator<T>().deallocate(pointer, n);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const
+  {
+    return false;
+  }
+};
+
+using CountingHashMap = aisdi::SmallMap<aisdi::HashMap<std::int32_t, std::int32_t, std::hash<std::int32_t>,
+                                                       std::equal_to<std::int32_t>, aisdi::PowerOfTwoIndexing, false,
+                                                       CountingAllocator<std::pair<std::int32_t, std::int32_t>>>, 8>;
+using HashMap = aisdi::SmallHashMap<std::int32_t, std::int32_t, 8>;
+using TreeMap = aisdi::SmallTreeMap<std::int32_t, std::int32_t, 8>;
+
+template <typename Map>
+void thenMapContainsItems(const Map& map, const std::map<std::int32_t, std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  std::size_t iterated = 0;
+  for (const auto& item : map)
+  {
+    auto it = expected.find(item.first);
+    BOOST_REQUIRE_MESSAGE(it != expected.end(), "Unexpected key: " << item.first);
+    BOOST_CHECK_EQUAL(item.second, it->second);
+    ++iterated;
+  }
+  BOOST_CHECK_EQUAL(iterated, expected.size());
+
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(map.find(item.first) != map.end(), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  }
+}
+
+template <typename Map>
+std::vector<std::int32_t> keysOf(const Map& map)
+{
+  std::vector<std::int32_t> keys;
+  for (const auto& item : map)
+    keys.push_back(item.first);
+  return keys;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SmallMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenSmallMap_WhenFillingUpToInlineCapacity_ThenNothingIsAllocated)
+{
+  allocationsCount = 0;
+  CountingHashMap map;
+  for (std::int32_t i = 0; i < 8; ++i)
+    map[i * 3] = i;
+  map.remove(3);
+  map.insert_or_assign(3, 1);
+  map.try_emplace(6, 1);
+  map.remove(map.find(0));
+  map.emplace(0, 2);
+
+  BOOST_CHECK(map.isSmall());
+  BOOST_CHECK_EQUAL(map.getSize(), 8u);
+  BOOST_CHECK_EQUAL(allocationsCount, 0u);
+
+  map[100] = 1;
+  BOOST_CHECK(!map.isSmall());
+  BOOST_CHECK_GT(allocationsCount, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallTreeMap_WhenAddingAndRemovingItems_ThenTheyAreIteratedInOrder)
+{
+  TreeMap map;
+  for (std::int32_t key : { 5, 1, 7, 3, 2 })
+    map[key] = key;
+  map.remove(3);
+
+  BOOST_CHECK(keysOf(map) == std::vector<std::int32_t>({ 1, 2, 5, 7 }));
+  auto it = map.end();
+  BOOST_CHECK_EQUAL((--it)->first, 7);
+  BOOST_CHECK_THROW(++map.end(), std::out_of_range);
+  BOOST_CHECK_THROW(--map.begin(), std::out_of_range);
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFullSmallMap_WhenAddingOneMoreItem_ThenItSpillsKeepingAllItems)
+{
+  HashMap hashMap;
+  TreeMap treeMap;
+  std::map<std::int32_t, std::int32_t> expected;
+  for (std::int32_t i = 0; i < 9; ++i)
+  {
+    const auto key = (i * 5) % 9;
+    BOOST_CHECK(hashMap.isSmall());
+    BOOST_CHECK(treeMap.isSmall());
+    hashMap[key] = i;
+    treeMap[key] = i;
+    expected[key] = i;
+  }
+
+  BOOST_CHECK(!hashMap.isSmall());
+  BOOST_CHECK(!treeMap.isSmall());
+  thenMapContainsItems(hashMap, expected);
+  thenMapContainsItems(treeMap, expected);
+  BOOST_CHECK(keysOf(treeMap) == std::vector<std::int32_t>({ 0, 1, 2, 3, 4, 5, 6, 7, 8 }));
+
+  for (std::int32_t key = 0; key < 8; ++key)
+    hashMap.remove(key);
+  BOOST_CHECK(!hashMap.isSmall());
+  thenMapContainsItems(hashMap, { { 8, expected[8] } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenValueOfInlineItem_WhenTryEmplacingItIntoFullMap_ThenItIsCopiedBeforeSpilling)
+{
+  aisdi::SmallHashMap<std::int32_t, std::string, 4> hashMap;
+  aisdi::SmallTreeMap<std::int32_t, std::string, 4> treeMap;
+  const std::string value(40, 'x');
+  for (std::int32_t i = 0; i < 4; ++i)
+  {
+    hashMap[i] = value;
+    treeMap[i] = value;
+  }
+
+  hashMap.try_emplace(100, hashMap.valueOf(0));
+  treeMap.try_emplace(100, treeMap.valueOf(0));
+
+  BOOST_CHECK(!hashMap.isSmall());
+  BOOST_CHECK(!treeMap.isSmall());
+  BOOST_CHECK_EQUAL(hashMap.valueOf(100), value);
+  BOOST_CHECK_EQUAL(treeMap.valueOf(100), value);
+  BOOST_CHECK_EQUAL(hashMap.valueOf(0), value);
+  BOOST_CHECK_EQUAL(treeMap.valueOf(0), value);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMoveOnlyValues_WhenSpilling_ThenValuesAreMovedIntoLargeMap)
+{
+  aisdi::SmallHashMap<std::int32_t, std::unique_ptr<std::int32_t>, 4> hashMap;
+  aisdi::SmallTreeMap<std::int32_t, std::unique_ptr<std::int32_t>, 4> treeMap;
+  for (std::int32_t i = 0; i < 10; ++i)
+  {
+    hashMap.try_emplace(i, new std::int32_t(i));
+    treeMap.try_emplace(i, new std::int32_t(i));
+  }
+
+  BOOST_CHECK(!hashMap.isSmall());
+  BOOST_CHECK(!treeMap.isSmall());
+  for (std::int32_t i = 0; i < 10; ++i)
+  {
+    BOOST_CHECK_EQUAL(*hashMap.valueOf(i), i);
+    BOOST_CHECK_EQUAL(*treeMap.valueOf(i), i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenInitializerListWithDuplicateKeys_WhenCreatingMap_ThenFirstValueIsKept)
+{
+  const HashMap small = { { 1, 1 }, { 2, 2 }, { 1, 3 } };
+  const TreeMap spilled = { { 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 },
+                            { 6, 6 }, { 7, 7 }, { 8, 8 }, { 1, -1 }, { 8, -8 } };
+
+  BOOST_CHECK(small.isSmall());
+  BOOST_CHECK(!spilled.isSmall());
+  thenMapContainsItems(small, { { 1, 1 }, { 2, 2 } });
+  thenMapContainsItems(spilled, { { 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 5 },
+                                  { 6, 6 }, { 7, 7 }, { 8, 8 } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingKey_WhenReadingOrRemoving_ThenItThrows)
+{
+  HashMap map = { { 1, 1 } };
+
+  BOOST_CHECK(map.find(2) == map.end());
+  BOOST_CHECK_THROW(map.valueOf(2), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(2), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInlineOrSpilledMap_WhenCopyingAndMoving_ThenItemsFollow)
+{
+  for (std::int32_t count : { 4, 20 })
+  {
+    aisdi::SmallHashMap<std::int32_t, std::string, 8> map;
+    std::map<std::int32_t, std::string> expected;
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+      map[i] = std::to_string(i);
+      expected[i] = std::to_string(i);
+    }
+
+    auto copy = map;
+    BOOST_CHECK(copy == map);
+    BOOST_CHECK_EQUAL(copy.isSmall(), map.isSmall());
+
+    auto moved = std::move(map);
+    BOOST_CHECK(map.isEmpty());
+    BOOST_CHECK(map.isSmall());
+    BOOST_CHECK(moved == copy);
+
+    map = moved;
+    moved = std::move(copy);
+    BOOST_CHECK(moved == map);
+    BOOST_CHECK_EQUAL(moved.getSize(), static_cast<std::size_t>(count));
+    BOOST_CHECK_EQUAL(moved.valueOf(count - 1), std::to_string(count - 1));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
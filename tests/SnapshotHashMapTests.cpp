@@ -0,0 +1,181 @@
+#include "../src/SnapshotHashMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+using Map = aisdi::SnapshotHashMap<std::int32_t, std::int32_t>;
+
+template <typename Function>
+void runInThreads(std::size_t threadsCount, Function function)
+{
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threadsCount; ++i)
+    threads.emplace_back(function, i);
+  for (auto& thread : threads)
+    thread.join();
+}
+
+const std::size_t threadsCount = 8;
+
+// Counts live instances to tell whether old snapshots are freed.
+struct Counted
+{
+  static std::atomic<std::ptrdiff_t> alive;
+
+  Counted(std::int32_t value = 0) : value(value)
+  {
+    ++alive;
+  }
+
+  Counted(const Counted& other) : value(other.value)
+  {
+    ++alive;
+  }
+
+  Counted& operator=(const Counted&) = default;
+
+  ~Counted()
+  {
+    --alive;
+  }
+
+  std::int32_t value;
+};
+
+std::atomic<std::ptrdiff_t> Counted::alive(0);
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SnapshotHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenUpserting_ThenItemIsInsertedThenAssigned)
+{
+  Map map;
+  BOOST_CHECK(map.isEmpty());
+
+  BOOST_CHECK(map.upsert(42, 1));
+  BOOST_CHECK(!map.upsert(42, 2));
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), 2);
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingKey_WhenReadingOrRemoving_ThenItIsReported)
+{
+  Map map;
+  map.upsert(1, 1);
+  std::int32_t value = 0;
+
+  BOOST_CHECK(!map.find(2, value));
+  BOOST_CHECK_THROW(map.valueOf(2), std::out_of_range);
+  BOOST_CHECK(!map.remove(2));
+  BOOST_CHECK(map.find(1, value));
+  BOOST_CHECK_EQUAL(value, 1);
+  BOOST_CHECK(map.remove(1));
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenBuiltTable_WhenPublishing_ThenWholeContentIsReplaced)
+{
+  Map map(Map::map_type{ { 1, 1 }, { 2, 2 } });
+
+  map.publish(Map::map_type{ { 3, 3 } });
+
+  BOOST_CHECK(!map.contains(1));
+  BOOST_CHECK_EQUAL(map.valueOf(3), 3);
+  BOOST_CHECK_EQUAL(map.read([](const Map::map_type& table) { return table.getSize(); }), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThrowingWriter_WhenUpdating_ThenNothingIsPublished)
+{
+  Map map;
+  map.upsert(1, 1);
+
+  BOOST_CHECK_THROW(map.update([](Map::map_type& table) {
+    table[2] = 2;
+    throw std::runtime_error("writer failed");
+  }), std::runtime_error);
+
+  BOOST_CHECK(!map.contains(2));
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyUpdates_WhenNoReaderIsActive_ThenOldSnapshotsAreFreed)
+{
+  {
+    aisdi::SnapshotHashMap<std::int32_t, Counted> map;
+    for (std::int32_t i = 0; i < 100; ++i)
+      map.update([i](aisdi::SnapshotHashMap<std::int32_t, Counted>::map_type& table) { table[i] = Counted(i); });
+
+    // the current snapshot holds 100 values; at most a few old ones may wait
+    BOOST_CHECK_LT(Counted::alive.load(), 100 * 4);
+  }
+  aisdi::detail::EpochReclaimer::instance().flush();
+  BOOST_CHECK_EQUAL(Counted::alive.load(), 0);
+}
+
+// Every published version holds the same value under every key; a reader
+// that ever sees two different values within one read saw a torn update.
+BOOST_AUTO_TEST_CASE(GivenWriterPublishing_WhenReadingConcurrently_ThenEverySnapshotIsConsistent)
+{
+  const std::int32_t keys = 200;
+  Map::map_type initial;
+  for (std::int32_t i = 0; i < keys; ++i)
+    initial[i] = 0;
+  Map map(initial);
+
+  std::atomic<bool> done(false);
+  std::atomic<std::size_t> torn(0), wentBack(0);
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    if (thread == 0)
+    {
+      for (std::int32_t version = 1; version <= 500; ++version)
+        map.update([version](Map::map_type& table) {
+          for (auto& item : table)
+            item.second = version;
+        });
+      done = true;
+      return;
+    }
+
+    std::int32_t lastSeen = 0;
+    while (!done)
+    {
+      map.read([&](const Map::map_type& table) {
+        const auto version = table.valueOf(0);
+        for (auto& item : table)
+          torn += item.second != version;
+        wentBack += version < lastSeen;
+        lastSeen = version;
+      });
+    }
+  });
+
+  BOOST_CHECK_EQUAL(torn.load(), 0);
+  BOOST_CHECK_EQUAL(wentBack.load(), 0);
+  BOOST_CHECK_EQUAL(map.valueOf(keys - 1), 500);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyWriters_WhenUpsertingDisjointKeys_ThenNoUpdateIsLost)
+{
+  Map map;
+
+  runInThreads(threadsCount, [&](std::size_t thread) {
+    for (std::int32_t i = 0; i < 200; ++i)
+      map.upsert(static_cast<std::int32_t>(i * threadsCount + thread), i);
+  });
+
+  BOOST_CHECK_EQUAL(map.getSize(), threadsCount * 200);
+  for (std::int32_t key = 0; key < static_cast<std::int32_t>(threadsCount * 200); ++key)
+    BOOST_REQUIRE_EQUAL(map.valueOf(key), key / static_cast<std::int32_t>(threadsCount));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+#include "../src/StringHashMap.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+std::string keyOf(int i)
+{
+  // short keys that fit std::string's own buffer and longer ones that do not
+  return i % 3 == 0 ? "key" + std::to_string(i) : "a much longer key than the others, number " + std::to_string(i);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(StringHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenManyKeys_WhenInserting_ThenTheyAreFoundByStringAndLiteral)
+{
+  aisdi::StringHashMap<int> map;
+  std::map<std::string, int> expected;
+  for (int i = 0; i < 10000; ++i)
+  {
+    map[keyOf(i)] = i;
+    expected[keyOf(i)] = i;
+  }
+  map[""] = -1;
+  expected[""] = -1;
+
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  for (auto& item : expected)
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  BOOST_CHECK_EQUAL(map.valueOf("key42"), 42);
+  BOOST_CHECK(map.find("key43") == map.end());
+  BOOST_CHECK_THROW(map.valueOf("key1"), std::out_of_range);
+
+  std::map<std::string, int> iterated;
+  for (const auto& item : map)
+    iterated[item.first.str()] = item.second;
+  BOOST_CHECK(iterated == expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenKeysWithNullBytes_WhenLookingUp_ThenWholeKeysAreCompared)
+{
+  aisdi::StringHashMap<int> map;
+  const std::string first("a\0b", 3), second("a\0c", 3);
+  map[first] = 1;
+  map[second] = 2;
+  map["a"] = 3;
+
+  BOOST_CHECK_EQUAL(map.getSize(), 3u);
+  BOOST_CHECK_EQUAL(map.valueOf(first), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(aisdi::StringKey("a\0c", 3)), 2);
+  BOOST_CHECK_EQUAL(map.valueOf("a"), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMostKeysRemoved_WhenArenaIsCompacted_ThenTheRestIsFound)
+{
+  aisdi::StringHashMap<std::string> map;
+  for (int i = 0; i < 2000; ++i)
+    map[keyOf(i)] = keyOf(i);
+
+  for (int i = 0; i < 2000; ++i)
+  {
+    if (i % 10 != 0)
+      map.remove(keyOf(i));
+  }
+  map.remove(map.find(keyOf(0)));
+
+  BOOST_CHECK_EQUAL(map.getSize(), 199u);
+  for (int i = 10; i < 2000; i += 10)
+    BOOST_CHECK_EQUAL(map.valueOf(keyOf(i)), keyOf(i));
+  BOOST_CHECK(map.find(keyOf(1)) == map.end());
+  BOOST_CHECK_THROW(map.remove(keyOf(1)), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(map.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenKeyFromTheMapItself_WhenInsertingIt_ThenItsBytesAreCopied)
+{
+  aisdi::StringHashMap<int> map;
+  map["abcdefgh"] = 1;
+  for (int i = 0; i < 100; ++i)
+  {
+    auto it = map.find("abcdefgh");
+    map[aisdi::StringKey(it->first.data(), 1 + i % 8)] += 1;
+    map[std::to_string(i)] = i;
+  }
+
+  BOOST_CHECK_EQUAL(map.valueOf("abcdefgh"), 1 + 12);
+  BOOST_CHECK_EQUAL(map.valueOf("a"), 13);
+  BOOST_CHECK_EQUAL(map.valueOf("abcdefg"), 12);
+}
+
+BOOST_AUTO_TEST_CASE(GivenValueFromTheMapItself_WhenTryEmplacingAcrossGrowth_ThenItIsCopied)
+{
+  aisdi::StringHashMap<std::string> map;
+  const std::string value(40, 'x');
+  for (int i = 0; i < 1000; ++i)
+    map.try_emplace(std::to_string(i), i == 0 ? value : map.valueOf("0"));
+
+  for (int i = 0; i < 1000; ++i)
+    BOOST_REQUIRE_EQUAL(map.valueOf(std::to_string(i)), value);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInitializerListWithDuplicateKeys_WhenCreatingMap_ThenFirstValueIsKept)
+{
+  const aisdi::StringHashMap<int> map = { { "a", 1 }, { "b", 2 }, { "a", 3 } };
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+  BOOST_CHECK_EQUAL(map.valueOf("a"), 1);
+  BOOST_CHECK_EQUAL(map.valueOf("b"), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenCopyingAndMoving_ThenItemsFollow)
+{
+  aisdi::StringHashMap<std::string> map = { { "one", "1" }, { "two", "2" }, { "three", "3" } };
+  auto copy = map;
+  copy["four"] = "4";
+  copy.remove("four");
+  BOOST_CHECK(copy == map);
+
+  copy.find("two")->second = "II";
+  BOOST_CHECK(copy != map);
+  BOOST_CHECK_EQUAL(map.valueOf("two"), "2");
+
+  auto moved = std::move(copy);
+  BOOST_CHECK(copy.isEmpty());
+  BOOST_CHECK_EQUAL(moved.valueOf("two"), "II");
+  BOOST_CHECK_THROW(*moved.end(), std::out_of_range);
+  auto last = --moved.end();
+  BOOST_CHECK_EQUAL(moved.valueOf(last->first), last->second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -786,6 +788,93 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTransparentComparator_WhenSearchingWithOtherKeyType_ThenNoKeyIsConstructed)
+{
+  aisdi::TreeMap<OperationCountingObject, std::string, std::less<>> map;
+  map[OperationCountingObject(27)] = "Bob";
+  map[OperationCountingObject(42)] = "Alice";
+  map[OperationCountingObject(13)] = "Chuck";
+  OperationCountingObject::resetCounters();
+
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+  BOOST_CHECK_EQUAL(map.find(27)->second, "Bob");
+  BOOST_CHECK(map.find(7) == map.end());
+  map.remove(13);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(OperationCountingObject::constructedObjectsCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeysAndTransparentComparator_WhenSearchingWithCString_ThenItemIsFound)
+{
+  const aisdi::TreeMap<std::string, int, std::less<>> map = { { "Alice", 1 }, { "Bob", 2 } };
+
+  BOOST_CHECK_EQUAL(map.valueOf("Bob"), 2);
+  BOOST_CHECK(map.find("Chuck") == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptyMap_WhenTryEmplacingKeys_ThenOnlyMissingOnesAreInserted)
+{
+  aisdi::TreeMap<int, std::string> map = { { 1, "a" } };
+
+  auto existing = map.try_emplace(1, "b");
+  auto inserted = map.try_emplace(2, 3, 'c');
+
+  BOOST_CHECK(!existing.second);
+  BOOST_CHECK_EQUAL(existing.first->second, "a");
+  BOOST_CHECK(inserted.second);
+  BOOST_CHECK_EQUAL(inserted.first->second, "ccc");
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMoveOnlyValues_WhenTryEmplacingAndRemoving_ThenValuesAreKept)
+{
+  aisdi::TreeMap<int, std::unique_ptr<int>> map;
+  for (int i = 0; i < 100; ++i)
+    map.try_emplace(i, new int(i));
+  std::unique_ptr<int> other(new int(-1));
+  BOOST_CHECK(!map.try_emplace(0, std::move(other)).second);
+  BOOST_CHECK(other != nullptr);
+  for (int i = 1; i < 100; i += 2)
+    map.remove(i);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 50);
+  for (int i = 0; i < 100; i += 2)
+    BOOST_CHECK_EQUAL(*map.valueOf(i), i);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSortedItems_WhenAssigningThem_ThenMapHoldsThemInOrder)
+{
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 1000; ++i)
+    items.emplace_back(i * 2, i);
+  aisdi::TreeMap<int, int> map = { { 5, 5 } };
+
+  map.assignSorted(items.begin(), items.size());
+
+  BOOST_CHECK_EQUAL(map.getSize(), items.size());
+  BOOST_CHECK(map.find(5) == map.end());
+  std::size_t i = 0;
+  for (auto& item : map)
+    BOOST_REQUIRE(item == items[i++]);
+  map[1] = 1;
+  map.remove(0);
+  BOOST_CHECK_EQUAL(map.begin()->first, 1);
+  BOOST_CHECK_EQUAL((--map.end())->first, 1998);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyItems_WhenIteratingBackwards_ThenAllAreVisitedInReverseOrder)
+{
+  aisdi::TreeMap<int, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[(i * 37) % 100] = i;
+
+  int expected = 99;
+  for (auto it = map.end(); it != map.begin(); --expected)
+    BOOST_REQUIRE_EQUAL((--it)->first, expected);
+  BOOST_CHECK_EQUAL(expected, -1);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
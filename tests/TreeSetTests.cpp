@@ -0,0 +1,101 @@
+#include "../src/TreeSet.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using Set = aisdi::TreeSet<std::int32_t>;
+
+namespace
+{
+
+void thenSetHoldsInOrder(const Set& set, const std::set<std::int32_t>& expected)
+{
+  BOOST_CHECK_EQUAL(set.getSize(), expected.size());
+  BOOST_CHECK(std::vector<std::int32_t>(set.begin(), set.end()) ==
+              std::vector<std::int32_t>(expected.begin(), expected.end()));
+  for (auto key : expected)
+    BOOST_CHECK_MESSAGE(set.contains(key), "Missing required key: " << key);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TreeSetTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptySet_WhenInsertingKeys_ThenTheyAreIteratedInOrder)
+{
+  Set set;
+  BOOST_CHECK(set.isEmpty());
+
+  for (std::int32_t key : { 5, 1, 4, 1, 3 })
+    set.insert(key);
+  auto again = set.insert(4);
+
+  BOOST_CHECK(!again.second);
+  BOOST_CHECK_EQUAL(*again.first, 4);
+  thenSetHoldsInOrder(set, { 1, 3, 4, 5 });
+}
+
+BOOST_AUTO_TEST_CASE(GivenSet_WhenRemovingKeys_ThenTheyAreGoneAndMissingOnesThrow)
+{
+  Set set = { 1, 2, 3, 4 };
+
+  set.remove(2);
+  set.remove(set.find(3));
+
+  thenSetHoldsInOrder(set, { 1, 4 });
+  BOOST_CHECK_THROW(set.remove(2), std::out_of_range);
+  BOOST_CHECK_THROW(set.remove(set.end()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonEmptySet_WhenInsertingUnsortedRange_ThenItIsMergedIn)
+{
+  Set set = { 10, 20, 30 };
+  std::vector<std::int32_t> keys = { 25, 5, 20, 5, 35 };
+
+  set.insert(keys.begin(), keys.end());
+
+  thenSetHoldsInOrder(set, { 5, 10, 20, 25, 30, 35 });
+  set.insert(15);
+  set.remove(5);
+  thenSetHoldsInOrder(set, { 10, 15, 20, 25, 30, 35 });
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoSets_WhenCombiningThem_ThenResultsMatchStdAlgorithms)
+{
+  std::vector<std::int32_t> firstKeys, secondKeys;
+  for (std::int32_t i = 0; i < 2000; ++i)
+    firstKeys.push_back(i * 3);
+  for (std::int32_t i = 0; i < 500; ++i)
+    secondKeys.push_back(i * 4);
+  Set first(firstKeys.begin(), firstKeys.end()), second(secondKeys.begin(), secondKeys.end());
+
+  std::set<std::int32_t> expectedUnion, expectedIntersection, expectedDifference;
+  std::set_union(firstKeys.begin(), firstKeys.end(), secondKeys.begin(), secondKeys.end(),
+                 std::inserter(expectedUnion, expectedUnion.end()));
+  std::set_intersection(firstKeys.begin(), firstKeys.end(), secondKeys.begin(), secondKeys.end(),
+                        std::inserter(expectedIntersection, expectedIntersection.end()));
+  std::set_difference(firstKeys.begin(), firstKeys.end(), secondKeys.begin(), secondKeys.end(),
+                      std::inserter(expectedDifference, expectedDifference.end()));
+
+  thenSetHoldsInOrder(unionOf(first, second), expectedUnion);
+  thenSetHoldsInOrder(intersectionOf(second, first), expectedIntersection);
+  thenSetHoldsInOrder(differenceOf(first, second), expectedDifference);
+  thenSetHoldsInOrder(differenceOf(second, second), {});
+  BOOST_CHECK(unionOf(first, second) == unionOf(second, first));
+  BOOST_CHECK(first != second);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCustomComparator_WhenInsertingKeys_ThenItDecidesOrderAndEquality)
+{
+  aisdi::TreeSet<std::string, std::greater<std::string>> set = { "b", "c", "a", "b" };
+
+  BOOST_CHECK(std::vector<std::string>(set.begin(), set.end()) == std::vector<std::string>({ "c", "b", "a" }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()